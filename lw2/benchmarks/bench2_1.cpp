@@ -0,0 +1,148 @@
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../task2_1/LifeGame.h"
+#include "../task2_1/_timer.h"
+
+const std::string FLAG_QUICK = "--quick";
+const int WARMUP_REPETITIONS = 1;
+const int REPETITIONS = 7;
+// сколько клеток обновить за один замер, чтобы маленькие поля не мерялись одним шагом
+const double CELLS_PER_REPETITION = 16.0 * 1024 * 1024;
+
+struct LifeEngine
+{
+    std::string name;
+    std::function<void(LifeGame&, int)> step;
+};
+
+struct BenchmarkConfig
+{
+    std::vector<int> sizes;
+    std::vector<double> densities;
+    std::vector<int> threadCounts;
+};
+
+struct BenchmarkResult
+{
+    double medianCups = 0;
+    double p95Cups = 0;
+};
+
+std::vector<LifeEngine> GetEngines()
+{
+    return {
+            {"strips", [](LifeGame& game, int numThreads) { game.Step(numThreads); }},
+    };
+}
+
+std::vector<int> GetThreadCounts()
+{
+    int maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts;
+    for (int n = 1; n < maxThreads; n *= 2)
+    {
+        threadCounts.push_back(n);
+    }
+    threadCounts.push_back(maxThreads);
+    return threadCounts;
+}
+
+BenchmarkConfig GetConfig(bool isQuick)
+{
+    // от полей, целиком лежащих в L1/L2, до полей, упирающихся в память
+    if (isQuick)
+    {
+        return {{64, 512, 2048}, {0.3}, GetThreadCounts()};
+    }
+    return {{64, 256, 1024, 4096}, {0.1, 0.3, 0.5}, GetThreadCounts()};
+}
+
+std::vector<std::string> GenerateField(int size, double density)
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    std::vector<std::string> field(size, std::string(size, EMPTY));
+    for (auto& row : field)
+    {
+        for (auto& cell : row)
+        {
+            cell = dis(gen) < density ? FILLED : EMPTY;
+        }
+    }
+    return field;
+}
+
+double Percentile(std::vector<double> values, double percentile)
+{
+    std::sort(values.begin(), values.end());
+    auto index = static_cast<size_t>(percentile * static_cast<double>(values.size() - 1) + 0.5);
+    return values[index];
+}
+
+BenchmarkResult Measure(const LifeEngine& engine, std::vector<std::string> field, int size, int numThreads)
+{
+    double cells = static_cast<double>(size) * size;
+    int steps = std::max(1, static_cast<int>(CELLS_PER_REPETITION / cells));
+
+    std::vector<double> times;
+    for (int repetition = 0; repetition < WARMUP_REPETITIONS + REPETITIONS; repetition++)
+    {
+        // каждый замер начинается с одного и того же поля, иначе поздние замеры шли бы по выродившейся популяции
+        LifeGame game(size, size, field);
+        Timer timer;
+        for (int i = 0; i < steps; i++)
+        {
+            engine.step(game, numThreads);
+        }
+        double elapsed = timer.GetElapsed();
+        if (repetition >= WARMUP_REPETITIONS)
+        {
+            times.push_back(elapsed);
+        }
+    }
+
+    double updates = cells * steps;
+    return {updates / Percentile(times, 0.5), updates / Percentile(times, 0.95)};
+}
+
+int main(int argc, char* argv[])
+{
+    bool isQuick = argc > 1 && argv[1] == FLAG_QUICK;
+    BenchmarkConfig config = GetConfig(isQuick);
+
+    std::cout << "engine,size,density,threads,median_cups,p95_cups,speedup,efficiency" << std::endl;
+    for (const auto& engine : GetEngines())
+    {
+        for (int size : config.sizes)
+        {
+            for (double density : config.densities)
+            {
+                std::vector<std::string> field = GenerateField(size, density);
+                double baseCups = 0;
+                for (int numThreads : config.threadCounts)
+                {
+                    BenchmarkResult result = Measure(engine, field, size, numThreads);
+                    if (numThreads == config.threadCounts.front())
+                    {
+                        baseCups = result.medianCups / numThreads;
+                    }
+
+                    double speedup = result.medianCups / baseCups;
+                    std::cout << engine.name << ',' << size << ',' << density << ',' << numThreads << ','
+                              << std::fixed << std::setprecision(0) << result.medianCups << ','
+                              << result.p95Cups << ',' << std::setprecision(2) << speedup << ','
+                              << speedup / numThreads << std::defaultfloat << std::endl;
+                }
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
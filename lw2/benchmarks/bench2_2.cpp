@@ -0,0 +1,269 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "../task2_2/GaussBlur.h"
+#include "../task2_2/_timer.h"
+
+const std::string FLAG_QUICK = "--quick";
+const int WARMUP_REPETITIONS = 1;
+const int REPETITIONS = 3;
+// точность меряется на VGA: эталон во float64 на больших кадрах и радиусах считался бы часами
+const int REFERENCE_WIDTH = 640;
+const int REFERENCE_HEIGHT = 480;
+
+struct BlurEngine
+{
+    std::string name;
+    BlurMode mode;
+    // ниже этого PSNR относительно эталона прогон считается проваленным
+    double minPsnr;
+};
+
+struct Resolution
+{
+    std::string name;
+    int width;
+    int height;
+};
+
+struct BenchmarkConfig
+{
+    std::vector<Resolution> resolutions;
+    std::vector<int> radii;
+    std::vector<int> threadCounts;
+};
+
+std::vector<BlurEngine> GetEngines()
+{
+    return {
+            {"exact", BlurMode::Exact, 50.0},
+            {"fused", BlurMode::Fused, 50.0},
+            {"box", BlurMode::Box, 25.0},
+    };
+}
+
+std::vector<int> GetThreadCounts()
+{
+    int maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts;
+    for (int n = 1; n < maxThreads; n *= 2)
+    {
+        threadCounts.push_back(n);
+    }
+    threadCounts.push_back(maxThreads);
+    return threadCounts;
+}
+
+BenchmarkConfig GetConfig(bool isQuick)
+{
+    if (isQuick)
+    {
+        return {{{"VGA", 640, 480}, {"FHD", 1920, 1080}}, {1, 10, 50}, GetThreadCounts()};
+    }
+    return {
+            {{"VGA", 640, 480}, {"HD", 1280, 720}, {"FHD", 1920, 1080}, {"4K", 3840, 2160}, {"8K", 7680, 4320}},
+            {1, 5, 20, 100, 500},
+            GetThreadCounts()
+    };
+}
+
+// шум поверх градиентов и резких границ, чтобы размытию было что сглаживать на всех масштабах
+cv::Mat GenerateImage(int width, int height)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> noise(-32, 32);
+
+    cv::Mat image(height, width, CV_8UC3);
+    for (int y = 0; y < height; y++)
+    {
+        auto* pixel = image.ptr<uchar>(y);
+        for (int x = 0; x < width; x++)
+        {
+            int edge = ((x / 64) + (y / 64)) % 2 == 0 ? 64 : 0;
+            int base[3] = {x * 255 / width, y * 255 / height, (x + y) * 255 / (width + height)};
+            for (int c = 0; c < 3; c++)
+            {
+                pixel[x * 3 + c] = static_cast<uchar>(std::clamp(base[c] / 2 + edge + noise(gen), 0, 255));
+            }
+        }
+    }
+    return image;
+}
+
+// прямая свертка во float64 по определению: гамма, гаусс по строкам, по столбцам, обратная гамма
+std::vector<double> BlurReference(const cv::Mat& image, int radius)
+{
+    // та же sigma, что выбирает GaussBlur для радиуса
+    double sigma = 0.3 * ((radius - 1) * 0.5 - 1) + 0.8;
+    std::vector<double> kernel(2 * radius + 1);
+    double sum = 0;
+    for (int i = -radius; i <= radius; i++)
+    {
+        kernel[i + radius] = std::exp(-(i * i) / (2 * sigma * sigma));
+        sum += kernel[i + radius];
+    }
+    for (double& k : kernel)
+    {
+        k /= sum;
+    }
+
+    int width = image.cols;
+    int height = image.rows;
+    auto index = [&](int x, int y, int c) { return (static_cast<size_t>(y) * width + x) * 3 + c; };
+
+    std::vector<double> working(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width * 3; x++)
+        {
+            working[static_cast<size_t>(y) * width * 3 + x] = std::pow(image.ptr<uchar>(y)[x] / 255.0, 1 / GaussBlur::GAMMA);
+        }
+    }
+
+    std::vector<double> horizontal(working.size());
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                double value = 0;
+                for (int i = -radius; i <= radius; i++)
+                {
+                    value += kernel[i + radius] * working[index(std::clamp(x + i, 0, width - 1), y, c)];
+                }
+                horizontal[index(x, y, c)] = value;
+            }
+        }
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                double value = 0;
+                for (int i = -radius; i <= radius; i++)
+                {
+                    value += kernel[i + radius] * horizontal[index(x, std::clamp(y + i, 0, height - 1), c)];
+                }
+                working[index(x, y, c)] = std::pow(std::clamp(value, 0.0, 1.0), GaussBlur::GAMMA) * 255.0;
+            }
+        }
+    }
+    return working;
+}
+
+double CalculatePsnr(const cv::Mat& image, const std::vector<double>& reference)
+{
+    double squaredError = 0;
+    for (int y = 0; y < image.rows; y++)
+    {
+        for (int x = 0; x < image.cols * 3; x++)
+        {
+            double diff = image.ptr<uchar>(y)[x] - reference[static_cast<size_t>(y) * image.cols * 3 + x];
+            squaredError += diff * diff;
+        }
+    }
+    double mse = squaredError / (static_cast<double>(image.total()) * 3);
+    if (mse == 0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    return 10 * std::log10(255.0 * 255.0 / mse);
+}
+
+double Median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+double MeasureMegapixelsPerSecond(const BlurEngine& engine, const cv::Mat& source, int radius, int numThreads)
+{
+    GaussBlur blur(radius, numThreads, engine.mode);
+    cv::Mat image;
+
+    std::vector<double> times;
+    for (int repetition = 0; repetition < WARMUP_REPETITIONS + REPETITIONS; repetition++)
+    {
+        source.copyTo(image);
+        Timer timer;
+        blur.Apply(image);
+        double elapsed = timer.GetElapsed();
+        if (repetition >= WARMUP_REPETITIONS)
+        {
+            times.push_back(elapsed);
+        }
+    }
+    return static_cast<double>(source.total()) / 1e6 / Median(times);
+}
+
+int main(int argc, char* argv[])
+{
+    bool isQuick = argc > 1 && argv[1] == FLAG_QUICK;
+    BenchmarkConfig config = GetConfig(isQuick);
+    int maxThreads = config.threadCounts.back();
+
+    cv::Mat referenceImage = GenerateImage(REFERENCE_WIDTH, REFERENCE_HEIGHT);
+    std::map<int, std::vector<double>> references;
+    for (int radius : config.radii)
+    {
+        references[radius] = BlurReference(referenceImage, radius);
+    }
+
+    bool isFailed = false;
+    std::cout << "engine,resolution,width,height,radius,threads,median_mpps,speedup,efficiency,psnr_db" << std::endl;
+    for (const auto& engine : GetEngines())
+    {
+        std::map<int, double> psnrs;
+        for (int radius : config.radii)
+        {
+            cv::Mat blurred = referenceImage.clone();
+            GaussBlur(radius, maxThreads, engine.mode).Apply(blurred);
+            psnrs[radius] = CalculatePsnr(blurred, references[radius]);
+            if (psnrs[radius] < engine.minPsnr)
+            {
+                std::cerr << "FAIL: " << engine.name << " radius " << radius << " PSNR " << psnrs[radius]
+                          << " dB is below " << engine.minPsnr << " dB" << std::endl;
+                isFailed = true;
+            }
+        }
+
+        for (const auto& resolution : config.resolutions)
+        {
+            cv::Mat source = GenerateImage(resolution.width, resolution.height);
+            for (int radius : config.radii)
+            {
+                double baseMpps = 0;
+                for (int numThreads : config.threadCounts)
+                {
+                    double mpps = MeasureMegapixelsPerSecond(engine, source, radius, numThreads);
+                    if (numThreads == config.threadCounts.front())
+                    {
+                        baseMpps = mpps / numThreads;
+                    }
+
+                    double speedup = mpps / baseMpps;
+                    std::cout << engine.name << ',' << resolution.name << ',' << resolution.width << ','
+                              << resolution.height << ',' << radius << ',' << numThreads << ','
+                              << std::fixed << std::setprecision(1) << mpps << ',' << std::setprecision(2)
+                              << speedup << ',' << speedup / numThreads << ',' << std::setprecision(1)
+                              << psnrs[radius] << std::defaultfloat << std::endl;
+                }
+            }
+        }
+    }
+
+    return isFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
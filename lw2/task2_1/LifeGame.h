@@ -2,9 +2,14 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <random>
 #include <fstream>
 #include <thread>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string_view>
 #include "_helpers.h"
 #include "_fs.h"
 #include "_timer.h"
@@ -12,29 +17,182 @@
 const char FILLED = '#';
 const char EMPTY = '_';
 
-struct LifeGameData
+using LifeField = std::vector<std::string>;
+
+struct LifeGameStats
 {
-    int width = 0;
-    int height = 0;
-    std::vector<std::string> field;
+    unsigned long long generation = 0;
+    long long population = 0;
+    long long births = 0;
+    long long deaths = 0;
+    // ограничивающий прямоугольник живых клеток, у пустого поля все -1
+    int minX = -1;
+    int minY = -1;
+    int maxX = -1;
+    int maxY = -1;
+
+    void AddAlive(int x, int y)
+    {
+        if (population == 0)
+        {
+            minX = maxX = x;
+            minY = maxY = y;
+        }
+        else
+        {
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            maxX = std::max(maxX, x);
+            maxY = std::max(maxY, y);
+        }
+        population++;
+    }
+
+    void Merge(const LifeGameStats& other)
+    {
+        if (other.population != 0)
+        {
+            if (population == 0)
+            {
+                minX = other.minX;
+                minY = other.minY;
+                maxX = other.maxX;
+                maxY = other.maxY;
+            }
+            else
+            {
+                minX = std::min(minX, other.minX);
+                minY = std::min(minY, other.minY);
+                maxX = std::max(maxX, other.maxX);
+                maxY = std::max(maxY, other.maxY);
+            }
+        }
+        population += other.population;
+        births += other.births;
+        deaths += other.deaths;
+    }
+};
+
+// Представление одного поколения без копирования; удерживает его, поэтому остается валидным во время Step
+class LifeGameView
+{
+public:
+    LifeGameView(std::shared_ptr<const LifeField> field, int width, int height, unsigned long long generation)
+            : m_field(std::move(field)), m_width(width), m_height(height), m_generation(generation)
+    {}
+
+    [[nodiscard]] int GetWidth() const noexcept
+    {
+        return m_width;
+    }
+
+    [[nodiscard]] int GetHeight() const noexcept
+    {
+        return m_height;
+    }
+
+    [[nodiscard]] unsigned long long GetGeneration() const noexcept
+    {
+        return m_generation;
+    }
+
+    [[nodiscard]] std::string_view GetRow(int y) const
+    {
+        return (*m_field)[y];
+    }
+
+    [[nodiscard]] bool IsAlive(int x, int y) const
+    {
+        return (*m_field)[y][x] == FILLED;
+    }
+
+    // поле целиком, без копирования; ссылка валидна, пока жив view
+    [[nodiscard]] const LifeField& GetField() const noexcept
+    {
+        return *m_field;
+    }
+
+private:
+    std::shared_ptr<const LifeField> m_field;
+    int m_width = 0;
+    int m_height = 0;
+    unsigned long long m_generation = 0;
 };
 
 class LifeGame
 {
 public:
     explicit LifeGame(int width, int height, std::vector<std::string>& field)
-            : m_width(width), m_height(height), m_field(field)
+            : m_width(width),
+              m_height(height),
+              m_field(std::make_shared<FieldBuffer>(field)),
+              m_newField(std::make_shared<FieldBuffer>(field))
+    {
+        for (int y = 0; y < m_height; y++)
+        {
+            m_hash += HashRow(m_field->cells[y], y);
+            for (int x = 0; x < m_width; x++)
+            {
+                if (m_field->cells[y][x] == FILLED)
+                {
+                    m_stats.AddAlive(x, y);
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] int GetWidth() const noexcept
+    {
+        return m_width;
+    }
+
+    [[nodiscard]] int GetHeight() const noexcept
+    {
+        return m_height;
+    }
+
+    [[nodiscard]] unsigned long long GetGeneration() const
+    {
+        std::lock_guard lock(m_viewMutex);
+        return m_generation;
+    }
+
+    // хеш текущего поколения, совпадение хешей считается повтором поля
+    [[nodiscard]] unsigned long long GetHash() const
     {
-        m_newField = m_field;
+        std::lock_guard lock(m_viewMutex);
+        return m_hash;
     }
 
-    [[nodiscard]] LifeGameData GetGameData() const
+    // счетчики текущего поколения, собираются во время Step без отдельного прохода по полю
+    [[nodiscard]] LifeGameStats GetStats() const
     {
-        return LifeGameData{m_width, m_height, m_field};
+        std::lock_guard lock(m_viewMutex);
+        return m_stats;
+    }
+
+    // можно вызывать из других потоков во время Step
+    [[nodiscard]] LifeGameView GetView() const
+    {
+        std::lock_guard lock(m_viewMutex);
+        m_field->viewCount.fetch_add(1, std::memory_order_relaxed);
+        // deleter снимает отметку о view; буфер живет, пока на него ссылается сам deleter
+        std::shared_ptr<const LifeField> field(&m_field->cells, [buffer = m_field](const LifeField*) {
+            buffer->viewCount.fetch_sub(1, std::memory_order_release);
+        });
+        return LifeGameView{std::move(field), m_width, m_height, m_generation};
     }
 
     void Step(int numThreads)
     {
+        // предыдущее поколение еще удерживается чьим-то view — не перезаписываем его. Новые view на этот буфер
+        // не появятся: GetView отдает только m_field, а буферы поменялись местами под m_viewMutex
+        if (m_newField->viewCount.load(std::memory_order_acquire) > 0)
+        {
+            m_newField = std::make_shared<FieldBuffer>(LifeField(m_height, std::string(m_width, EMPTY)));
+        }
+
+        std::vector<SectionResult> results(numThreads);
         std::vector<std::jthread> threads;
         int chunkSize = m_height / numThreads;
 
@@ -42,7 +200,7 @@ public:
         {
             int startY = i * chunkSize;
             int endY = (i == numThreads - 1) ? m_height : (i + 1) * chunkSize;
-            threads.emplace_back(&LifeGame::UpdateSection, this, startY, endY);
+            threads.emplace_back(&LifeGame::UpdateSection, this, startY, endY, std::ref(results[i]));
         }
 
         for (auto& thread : threads)
@@ -50,16 +208,61 @@ public:
             thread.join();
         }
 
+        unsigned long long hash = 0;
+        LifeGameStats stats;
+        for (const auto& result : results)
+        {
+            hash += result.hash;
+            stats.Merge(result.stats);
+        }
+
+        std::lock_guard lock(m_viewMutex);
         m_field.swap(m_newField);
+        m_generation++;
+        m_hash = hash;
+        m_stats = stats;
+        m_stats.generation = m_generation;
     }
 
 private:
+    // поле вместе с числом выданных на него view
+    struct FieldBuffer
+    {
+        explicit FieldBuffer(LifeField field)
+                : cells(std::move(field))
+        {}
+
+        LifeField cells;
+        std::atomic<int> viewCount = 0;
+    };
+
     int m_width = 0;
     int m_height = 0;
-    std::vector<std::string> m_field;
-    std::vector<std::string> m_newField;
+    std::shared_ptr<FieldBuffer> m_field;
+    std::shared_ptr<FieldBuffer> m_newField;
+    unsigned long long m_generation = 0;
+    unsigned long long m_hash = 0;
+    LifeGameStats m_stats;
+    mutable std::mutex m_viewMutex;
 
-    int CountNeighbors(int x, int y)
+    // у каждого потока своя кэш-линия, чтобы не было false sharing
+    struct alignas(64) SectionResult
+    {
+        unsigned long long hash = 0;
+        LifeGameStats stats;
+    };
+
+    // хеш поля — сумма хешей строк, поэтому полосы потоков считаются независимо
+    static unsigned long long HashRow(std::string_view row, int y)
+    {
+        unsigned long long hash = std::hash<std::string_view>{}(row)
+                                  ^ (static_cast<unsigned long long>(y) * 0x9E3779B97F4A7C15ULL);
+        hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+        return hash ^ (hash >> 31);
+    }
+
+    int CountNeighbors(const LifeField& field, int x, int y) const
     {
         static const int dx[] = {-1, -1, -1, 0, 1, 1, 1, 0};
         static const int dy[] = {-1, 0, 1, 1, 1, 0, -1, -1};
@@ -69,7 +272,7 @@ private:
         {
             int nx = (x + dx[i] + m_width) % m_width;
             int ny = (y + dy[i] + m_height) % m_height;
-            if (m_field[ny][nx] == FILLED)
+            if (field[ny][nx] == FILLED)
             {
                 count++;
             }
@@ -77,17 +280,31 @@ private:
         return count;
     }
 
-    void UpdateSection(int startY, int endY)
+    void UpdateSection(int startY, int endY, SectionResult& result)
     {
+        const LifeField& field = m_field->cells;
+        LifeField& newField = m_newField->cells;
+
         for (int y = startY; y < endY; y++)
         {
             for (int x = 0; x < m_width; x++)
             {
-                int neighbors = CountNeighbors(x, y);
-                m_newField[y][x] = (m_field[y][x] == FILLED
-                                    ? (neighbors == 2 || neighbors == 3 ? FILLED : EMPTY)
-                                    : (neighbors == 3 ? FILLED : EMPTY));
+                int neighbors = CountNeighbors(field, x, y);
+                bool wasAlive = field[y][x] == FILLED;
+                bool isAlive = wasAlive ? (neighbors == 2 || neighbors == 3) : neighbors == 3;
+                newField[y][x] = isAlive ? FILLED : EMPTY;
+
+                if (isAlive)
+                {
+                    result.stats.AddAlive(x, y);
+                    result.stats.births += !wasAlive;
+                }
+                else
+                {
+                    result.stats.deaths += wasAlive;
+                }
             }
+            result.hash += HashRow(newField[y], y);
         }
     }
 };
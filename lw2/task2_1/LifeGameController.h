@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include "LifeGame.h"
+#include "LifeGamePeriodDetector.h"
 #include "LifeGameVisualizer.h"
 
 class LifeGameController
@@ -14,6 +15,44 @@ public:
         Timer timer;
         m_game->Step(numThreads);
         std::cout << "Total time: " << timer.GetElapsed() << " seconds" << std::endl;
+        WriteStats(m_game->GetStats());
+    }
+
+    // Шагает, пока поле не зациклится с периодом <= maxPeriod или не пройдет maxSteps поколений
+    void RunSteps(int numThreads, unsigned long long maxSteps, unsigned long long maxPeriod)
+    {
+        if (!m_game)
+        {
+            throw std::runtime_error("game not loaded");
+        }
+
+        Timer timer;
+        LifeGamePeriodDetector detector(maxPeriod);
+        std::optional<LifeGamePeriod> period = detector.Push(m_game->GetGeneration(), m_game->GetHash());
+        WriteStats(m_game->GetStats());
+
+        for (unsigned long long step = 0; step < maxSteps && !period; step++)
+        {
+            m_game->Step(numThreads);
+            period = detector.Push(m_game->GetGeneration(), m_game->GetHash());
+            WriteStats(m_game->GetStats());
+        }
+
+        if (period)
+        {
+            std::cout << "Period " << period->period << " detected, starting at generation "
+                      << period->startGeneration << std::endl;
+        }
+        std::cout << "Generations: " << m_game->GetGeneration() << std::endl;
+        std::cout << "Population: " << m_game->GetStats().population << std::endl;
+        std::cout << "Total time: " << timer.GetElapsed() << " seconds" << std::endl;
+    }
+
+    // CSV со статистикой каждого поколения, которое пройдет через RunStep/RunSteps
+    void SetStatsOutput(const std::string& statsPath)
+    {
+        FS::LoadStream(statsPath, m_statsStream, std::ios::out | std::ios::trunc);
+        m_statsStream << "generation,population,births,deaths,min_x,min_y,max_x,max_y" << std::endl;
     }
 
     void LoadGame(const std::string& inputPath)
@@ -47,10 +86,10 @@ public:
         FS::LoadStream(outputPath, output, std::ios::out | std::ios::trunc);
         output.clear();
         std::ostringstream oss;
-        LifeGameData gameData = m_game->GetGameData();
+        LifeGameView view = m_game->GetView();
 
-        oss << gameData.width << " " << gameData.height << std::endl;
-        for (const auto& row : gameData.field)
+        oss << view.GetWidth() << " " << view.GetHeight() << std::endl;
+        for (const auto& row : view.GetField())
         {
             oss << row << std::endl;
         }
@@ -93,5 +132,22 @@ public:
 
 private:
     std::unique_ptr<LifeGame> m_game = nullptr;
+    std::fstream m_statsStream;
+
+    void WriteStats(const LifeGameStats& stats)
+    {
+        if (!m_statsStream.is_open())
+        {
+            return;
+        }
+
+        m_statsStream << stats.generation << ',' << stats.population << ',' << stats.births << ','
+                      << stats.deaths << ',' << stats.minX << ',' << stats.minY << ','
+                      << stats.maxX << ',' << stats.maxY << '\n';
+        if (m_statsStream.fail())
+        {
+            throw std::runtime_error("error occurred while writing statistics");
+        }
+    }
 };
 
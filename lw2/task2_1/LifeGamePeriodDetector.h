@@ -0,0 +1,46 @@
+#pragma once
+
+#include <deque>
+#include <optional>
+
+struct LifeGamePeriod
+{
+    unsigned long long period = 0;
+    unsigned long long startGeneration = 0;
+};
+
+// Помнит хеши последних maxPeriod поколений и находит первый повтор поля
+class LifeGamePeriodDetector
+{
+public:
+    explicit LifeGamePeriodDetector(unsigned long long maxPeriod) : m_maxPeriod(maxPeriod)
+    {}
+
+    std::optional<LifeGamePeriod> Push(unsigned long long generation, unsigned long long hash)
+    {
+        for (auto it = m_history.rbegin(); it != m_history.rend(); ++it)
+        {
+            if (it->hash == hash)
+            {
+                return LifeGamePeriod{generation - it->generation, it->generation};
+            }
+        }
+
+        m_history.push_back(Entry{generation, hash});
+        if (m_history.size() > m_maxPeriod)
+        {
+            m_history.pop_front();
+        }
+        return std::nullopt;
+    }
+
+private:
+    struct Entry
+    {
+        unsigned long long generation = 0;
+        unsigned long long hash = 0;
+    };
+
+    unsigned long long m_maxPeriod;
+    std::deque<Entry> m_history;
+};
@@ -1,29 +1,57 @@
 #pragma once
 
 #include <iostream>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <SFML/Graphics.hpp>
 #include "LifeGame.h"
+#include "_timer.h"
 
 class LifeGameVisualizer
 {
 public:
-    explicit LifeGameVisualizer(LifeGame& game, int cellSize = 10) : m_game(game), m_cellSize(cellSize)
+    explicit LifeGameVisualizer(LifeGame& game, int cellSize = 10, int stepDelayMs = 500)
+            : m_game(game),
+              m_width(game.GetWidth()),
+              m_height(game.GetHeight()),
+              m_stepDelay(stepDelayMs)
     {
-        LifeGameData data = game.GetGameData();
-        m_width = data.width;
-        m_height = data.height;
-
-        m_window.create(sf::VideoMode(m_width * m_cellSize, m_height * m_cellSize), "Game of Life");
-        m_text.setCharacterSize(16);
-        m_text.setFillColor(sf::Color::White);
-        m_text.setPosition(10, 10);
+        // большие поля масштабируются под экран, одна клетка = один пиксель текстуры
+        sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
+        m_scale = std::min({
+                static_cast<float>(cellSize),
+                static_cast<float>(desktop.width) / static_cast<float>(m_width),
+                static_cast<float>(desktop.height) / static_cast<float>(m_height)
+        });
+
+        auto windowWidth = static_cast<unsigned>(std::max(1.0f, static_cast<float>(m_width) * m_scale));
+        auto windowHeight = static_cast<unsigned>(std::max(1.0f, static_cast<float>(m_height) * m_scale));
+        m_window.create(sf::VideoMode(windowWidth, windowHeight), "Game of Life");
+        m_window.setFramerateLimit(60);
+
+        if (!m_texture.create(static_cast<unsigned>(m_width), static_cast<unsigned>(m_height)))
+        {
+            throw std::runtime_error("failed to create texture");
+        }
+        m_texture.setSmooth(m_scale < 1.0f);
+        m_sprite.setTexture(m_texture, true);
+        m_sprite.setScale(m_scale, m_scale);
+
+        m_frontPixels.resize(static_cast<size_t>(m_width) * m_height * 4);
+        m_backPixels.resize(m_frontPixels.size());
     }
 
     void Run(int numThreads)
     {
-        sf::Clock clock;
-        float totalTime = 0;
-        int steps = 0;
+        RenderPixels(m_frontPixels, numThreads);
+        m_texture.update(m_frontPixels.data());
+
+        std::jthread simulationThread([this, numThreads](std::stop_token stopToken) {
+            Simulate(stopToken, numThreads);
+        });
 
         while (m_window.isOpen())
         {
@@ -33,51 +61,109 @@ public:
                 if (event.type == sf::Event::Closed)
                     m_window.close();
             }
+            if (!m_window.isOpen())
+            {
+                break;
+            }
 
-            sf::Time elapsed = clock.restart();
-            m_game.Step(numThreads);
-            totalTime += elapsed.asSeconds();
-            steps++;
-
-            float avgTime = totalTime / static_cast<float>(steps);
-            m_window.setTitle("Game of Life - Avg Time: " + std::to_string(avgTime) + "s");
+            UploadFrame();
 
-            Draw();
-            sf::sleep(sf::milliseconds(500));
+            m_window.clear(sf::Color::White);
+            m_window.draw(m_sprite);
+            m_window.display();
         }
+
+        simulationThread.request_stop();
     }
 
 private:
     LifeGame& m_game;
     sf::RenderWindow m_window;
+    sf::Texture m_texture;
+    sf::Sprite m_sprite;
     int m_width, m_height;
-    int m_cellSize;
-    sf::Text m_text;
+    float m_scale = 1.0f;
+    std::chrono::milliseconds m_stepDelay;
 
-    void Draw()
+    // front читает поток отрисовки, back заполняет поток симуляции
+    std::vector<sf::Uint8> m_frontPixels;
+    std::vector<sf::Uint8> m_backPixels;
+    std::mutex m_frameMutex;
+    bool m_isFrameReady = false;
+    double m_totalStepTime = 0;
+    int m_steps = 0;
+    long long m_population = 0;
+
+    void Simulate(std::stop_token stopToken, int numThreads)
     {
-        m_window.clear(sf::Color::White);
+        std::mutex delayMutex;
+        std::condition_variable_any delayCondition;
+
+        while (!stopToken.stop_requested())
+        {
+            Timer timer;
+            m_game.Step(numThreads);
+            double stepTime = timer.GetElapsed();
 
-        LifeGameData data = m_game.GetGameData();
-        sf::RectangleShape cell(sf::Vector2f(static_cast<float>(m_cellSize), static_cast<float>(m_cellSize)));
+            RenderPixels(m_backPixels, numThreads);
+            {
+                std::lock_guard lock(m_frameMutex);
+                m_frontPixels.swap(m_backPixels);
+                m_isFrameReady = true;
+                m_totalStepTime += stepTime;
+                m_steps++;
+                m_population = m_game.GetStats().population;
+            }
 
-        for (int y = 0; y < m_height; y++)
+            std::unique_lock lock(delayMutex);
+            delayCondition.wait_for(lock, stopToken, m_stepDelay, [] { return false; });
+        }
+    }
+
+    void UploadFrame()
+    {
+        std::lock_guard lock(m_frameMutex);
+        if (!m_isFrameReady)
         {
-            for (int x = 0; x < m_width; x++)
+            return;
+        }
+
+        m_texture.update(m_frontPixels.data());
+        m_isFrameReady = false;
+
+        double avgTime = m_totalStepTime / m_steps;
+        m_window.setTitle("Game of Life - Avg Time: " + std::to_string(avgTime) + "s - Population: "
+                          + std::to_string(m_population));
+    }
+
+    void RenderPixels(std::vector<sf::Uint8>& pixels, int numThreads) const
+    {
+        LifeGameView view = m_game.GetView();
+        const LifeField& field = view.GetField();
+
+        auto renderRows = [&](int startY, int endY) {
+            for (int y = startY; y < endY; y++)
             {
-                if (data.field[y][x] == FILLED)
-                {
-                    cell.setFillColor(sf::Color::Black);
-                }
-                else
+                const std::string& row = field[y];
+                sf::Uint8* pixel = pixels.data() + static_cast<size_t>(y) * m_width * 4;
+                for (int x = 0; x < m_width; x++, pixel += 4)
                 {
-                    cell.setFillColor(sf::Color::White);
+                    sf::Uint8 color = row[x] == FILLED ? 0 : 255;
+                    pixel[0] = color;
+                    pixel[1] = color;
+                    pixel[2] = color;
+                    pixel[3] = 255;
                 }
-                cell.setPosition(static_cast<float>(x * m_cellSize), static_cast<float>(y * m_cellSize));
-                m_window.draw(cell);
             }
-        }
+        };
 
-        m_window.display();
+        std::vector<std::jthread> threads;
+        int chunkSize = m_height / numThreads;
+        for (int i = 0; i < numThreads; i++)
+        {
+            int startY = i * chunkSize;
+            int endY = (i == numThreads - 1) ? m_height : (i + 1) * chunkSize;
+            threads.emplace_back(renderRows, startY, endY);
+        }
     }
-};
\ No newline at end of file
+};
@@ -6,25 +6,32 @@
 
 const std::string COMMAND_GENERATE = "generate";
 const std::string COMMAND_STEP = "step";
+const std::string COMMAND_RUN = "run";
 const std::string COMMAND_VISUALIZE = "visualize";
 
 void PrintUsage()
 {
     std::cerr << "Использование:" << std::endl
               << "  life generate OUTPUT_FILE WIDTH HEIGHT PROBABILITY" << std::endl
-              << "  life step INPUT_FILE NUM_THREADS [OUTPUT_FILE]" << std::endl;
+              << "  life step INPUT_FILE NUM_THREADS [OUTPUT_FILE]" << std::endl
+              << "  life run INPUT_FILE NUM_THREADS MAX_STEPS MAX_PERIOD [OUTPUT_FILE [STATS_CSV]]" << std::endl
+              << "  life visualize INPUT_FILE NUM_THREADS" << std::endl;
 }
 
 struct ProgramArgs
 {
     bool isGenerate = false;
     bool isVisualize = false;
+    bool isRun = false;
     std::string inputPath;
     std::string outputPath;
+    std::string statsPath;
     int width = 0;
     int height = 0;
     double probability = 0.0;
     int numThreads = 1;
+    unsigned long long maxSteps = 0;
+    unsigned long long maxPeriod = 0;
 };
 
 ProgramArgs ParseArgs(int argc, char* argv[])
@@ -66,6 +73,27 @@ ProgramArgs ParseArgs(int argc, char* argv[])
             args.outputPath = argv[4];
         }
     }
+    else if (EqualsIgnoreCase(command, COMMAND_RUN))
+    {
+        if (argc < 6 || argc > 8)
+        {
+            PrintUsage();
+            throw std::invalid_argument("invalid count of arguments for command: " + COMMAND_RUN);
+        }
+        args.isRun = true;
+        args.inputPath = argv[2];
+        args.numThreads = std::stoi(argv[3]);
+        args.maxSteps = std::stoull(argv[4]);
+        args.maxPeriod = std::stoull(argv[5]);
+        if (argc >= 7)
+        {
+            args.outputPath = argv[6];
+        }
+        if (argc == 8)
+        {
+            args.statsPath = argv[7];
+        }
+    }
     else if (EqualsIgnoreCase(command, COMMAND_VISUALIZE))
     {
         if (argc > 4)
@@ -102,6 +130,16 @@ int main(int argc, char* argv[])
             gameController.LoadGame(args.inputPath);
             gameController.Visualize(args.numThreads);
         }
+        else if (args.isRun)
+        {
+            gameController.LoadGame(args.inputPath);
+            if (!args.statsPath.empty())
+            {
+                gameController.SetStatsOutput(args.statsPath);
+            }
+            gameController.RunSteps(args.numThreads, args.maxSteps, args.maxPeriod);
+            gameController.SaveGame(args.outputPath.empty() ? args.inputPath : args.outputPath);
+        }
         else
         {
             gameController.LoadGame(args.inputPath);
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <iostream>
+#include <atomic>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <syncstream>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "BlockingQueue.h"
+#include "GaussBlur.h"
+#include "ImageProcessor.h"
+#include "_timer.h"
+
+struct BatchResult
+{
+    int processed = 0;
+    int failed = 0;
+    double seconds = 0;
+};
+
+// Конвейер из трех стадий: пока размывается изображение N, N+1 уже декодируется, а N-1 кодируется
+class BatchProcessor
+{
+public:
+    static const constexpr size_t QUEUE_CAPACITY = 2;
+
+    explicit BatchProcessor(GaussBlur& blur) : m_blur(blur)
+    {}
+
+    BatchResult Run(const std::vector<std::filesystem::path>& inputs, const std::filesystem::path& outputDir)
+    {
+        // результаты пишутся под теми же именами, поэтому в каталог исходников они молча затерли бы оригиналы
+        for (const auto& input : inputs)
+        {
+            std::filesystem::path inputDir = input.has_parent_path() ? input.parent_path() : ".";
+            if (std::filesystem::exists(outputDir) && std::filesystem::equivalent(inputDir, outputDir))
+            {
+                throw std::invalid_argument("output directory must differ from the input directory: "
+                                            + outputDir.string());
+            }
+        }
+        std::filesystem::create_directories(outputDir);
+
+        BatchResult result;
+        Timer timer;
+        BlockingQueue<Job> decoded(QUEUE_CAPACITY);
+        BlockingQueue<Job> blurred(QUEUE_CAPACITY);
+        std::atomic<int> failed = 0;
+
+        std::jthread decoder([&] {
+            for (const auto& input : inputs)
+            {
+                try
+                {
+                    decoded.Push(Job{ImageProcessor::LoadImage(input.string()), outputDir / input.filename()});
+                }
+                catch (const std::exception& e)
+                {
+                    ReportError(e.what());
+                    failed++;
+                }
+            }
+            decoded.Close();
+        });
+
+        std::jthread encoder([&] {
+            while (auto job = blurred.Pop())
+            {
+                try
+                {
+                    ImageProcessor::SaveImage(job->outputPath.string(), job->image);
+                    result.processed++;
+                }
+                catch (const std::exception& e)
+                {
+                    ReportError(e.what());
+                    failed++;
+                }
+            }
+        });
+
+        while (auto job = decoded.Pop())
+        {
+            try
+            {
+                m_blur.Apply(job->image);
+                blurred.Push(std::move(*job));
+            }
+            catch (const std::exception& e)
+            {
+                ReportError(e.what());
+                failed++;
+            }
+        }
+        blurred.Close();
+
+        decoder.join();
+        encoder.join();
+
+        result.failed = failed;
+        result.seconds = timer.GetElapsed();
+        return result;
+    }
+
+private:
+    struct Job
+    {
+        cv::Mat image;
+        std::filesystem::path outputPath;
+    };
+
+    GaussBlur& m_blur;
+
+    static void ReportError(const std::string& message)
+    {
+        std::osyncstream(std::cerr) << "Error: " << message << std::endl;
+    }
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+// Ограниченная очередь между стадиями конвейера; после Close Pop отдает остаток и затем nullopt
+template<typename T>
+class BlockingQueue
+{
+public:
+    explicit BlockingQueue(size_t capacity) : m_capacity(capacity)
+    {}
+
+    void Push(T value)
+    {
+        std::unique_lock lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_items.size() < m_capacity || m_isClosed; });
+        if (m_isClosed)
+        {
+            return;
+        }
+        m_items.push_back(std::move(value));
+        m_notEmpty.notify_one();
+    }
+
+    std::optional<T> Pop()
+    {
+        std::unique_lock lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return !m_items.empty() || m_isClosed; });
+        if (m_items.empty())
+        {
+            return std::nullopt;
+        }
+        T value = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return value;
+    }
+
+    void Close()
+    {
+        std::lock_guard lock(m_mutex);
+        m_isClosed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+private:
+    size_t m_capacity;
+    std::deque<T> m_items;
+    bool m_isClosed = false;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <opencv2/opencv.hpp>
+#include "GaussBlur.h"
+
+// Исходник не меняется: сразу отдается размытое уменьшенное превью, полное разрешение считается в фоне,
+// новый радиус отменяет незаконченный расчет, готовые результаты кэшируются по радиусу
+class BlurPreviewEngine
+{
+public:
+    static const constexpr int PREVIEW_MAX_SIZE = 640;
+    // кэш ограничен объемом, а не числом записей: один результат 8000x6000 RGBA 32F занимает больше 700 МБ
+    static const constexpr size_t CACHE_CAPACITY_BYTES = 512 * 1024 * 1024;
+
+    BlurPreviewEngine(const cv::Mat& original, int numThreads)
+            : m_original(original.clone()),
+              m_previewBlur(0, numThreads),
+              m_fullBlur(0, numThreads),
+              m_worker([this](std::stop_token stopToken) { WorkerLoop(stopToken); })
+    {
+        double scale = std::min(1.0, static_cast<double>(PREVIEW_MAX_SIZE) / std::max(original.cols, original.rows));
+        m_previewScale = scale;
+        cv::resize(m_original, m_preview,
+                cv::Size(std::max(1, static_cast<int>(original.cols * scale)),
+                        std::max(1, static_cast<int>(original.rows * scale))),
+                0, 0, cv::INTER_AREA);
+    }
+
+    BlurPreviewEngine(const BlurPreviewEngine&) = delete;
+    BlurPreviewEngine& operator=(const BlurPreviewEngine&) = delete;
+
+    // ожидающий радиус сбрасывается, иначе рабочий поток успел бы взять его и считать полный размер до join
+    ~BlurPreviewEngine()
+    {
+        std::lock_guard lock(m_mutex);
+        m_pendingRadius.reset();
+        m_jobStop.request_stop();
+        m_worker.request_stop();
+    }
+
+    // вызывается из потока интерфейса: результат из кэша или превью в размере исходника
+    cv::Mat Request(int radius)
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_currentRadius = radius;
+            m_completed.reset();
+            m_jobStop.request_stop();
+            if (auto cached = FindCached(radius))
+            {
+                m_pendingRadius.reset();
+                return *cached;
+            }
+            m_pendingRadius = radius;
+        }
+        m_wakeCondition.notify_one();
+
+        // радиус в пикселях превью, чтобы размытие выглядело так же, как на полном размере
+        cv::Mat preview = m_preview.clone();
+        m_previewBlur.SetRadius(static_cast<int>(std::round(radius * m_previewScale)));
+        m_previewBlur.Apply(preview);
+
+        cv::Mat upscaled;
+        cv::resize(preview, upscaled, m_original.size(), 0, 0, cv::INTER_LINEAR);
+        return upscaled;
+    }
+
+    // готовый результат полного разрешения для последнего запрошенного радиуса, если он появился
+    std::optional<cv::Mat> TakeCompleted()
+    {
+        std::lock_guard lock(m_mutex);
+        std::optional<cv::Mat> completed = std::move(m_completed);
+        m_completed.reset();
+        return completed;
+    }
+
+private:
+    cv::Mat m_original;
+    cv::Mat m_preview;
+    double m_previewScale = 1.0;
+    GaussBlur m_previewBlur;
+    GaussBlur m_fullBlur;
+
+    std::mutex m_mutex;
+    std::condition_variable_any m_wakeCondition;
+    std::optional<int> m_pendingRadius;
+    int m_currentRadius = -1;
+    std::stop_source m_jobStop;
+    std::optional<cv::Mat> m_completed;
+    std::map<int, cv::Mat> m_cache;
+    // радиусы от недавно использованных к давно использованным
+    std::list<int> m_cacheOrder;
+    size_t m_cacheBytes = 0;
+
+    std::jthread m_worker;
+
+    std::optional<cv::Mat> FindCached(int radius)
+    {
+        auto it = m_cache.find(radius);
+        if (it == m_cache.end())
+        {
+            return std::nullopt;
+        }
+        m_cacheOrder.remove(radius);
+        m_cacheOrder.push_front(radius);
+        return it->second;
+    }
+
+    static size_t GetBytes(const cv::Mat& image)
+    {
+        return image.total() * image.elemSize();
+    }
+
+    // результат больше всего кэша не сохраняется; остальные вытесняют давно использованные, пока не уложатся
+    void AddToCache(int radius, const cv::Mat& image)
+    {
+        if (GetBytes(image) > CACHE_CAPACITY_BYTES)
+        {
+            return;
+        }
+        if (auto it = m_cache.find(radius); it != m_cache.end())
+        {
+            m_cacheBytes -= GetBytes(it->second);
+        }
+        m_cache[radius] = image;
+        m_cacheBytes += GetBytes(image);
+        m_cacheOrder.remove(radius);
+        m_cacheOrder.push_front(radius);
+        while (m_cacheBytes > CACHE_CAPACITY_BYTES)
+        {
+            auto oldest = m_cache.find(m_cacheOrder.back());
+            m_cacheBytes -= GetBytes(oldest->second);
+            m_cache.erase(oldest);
+            m_cacheOrder.pop_back();
+        }
+    }
+
+    void WorkerLoop(std::stop_token stopToken)
+    {
+        while (true)
+        {
+            int radius;
+            std::stop_token jobToken;
+            {
+                std::unique_lock lock(m_mutex);
+                if (!m_wakeCondition.wait(lock, stopToken, [this] { return m_pendingRadius.has_value(); }))
+                {
+                    return;
+                }
+                radius = *m_pendingRadius;
+                m_pendingRadius.reset();
+                m_jobStop = std::stop_source();
+                jobToken = m_jobStop.get_token();
+            }
+
+            cv::Mat result = m_original.clone();
+            m_fullBlur.SetRadius(radius);
+            if (!m_fullBlur.Apply(result, jobToken))
+            {
+                continue;
+            }
+
+            std::lock_guard lock(m_mutex);
+            AddToCache(radius, result);
+            if (radius == m_currentRadius)
+            {
+                m_completed = result;
+            }
+        }
+    }
+};
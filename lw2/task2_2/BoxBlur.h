@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+#include <stop_token>
+#include <opencv2/opencv.hpp>
+#include "SeparableFilterEngine.h"
+
+// Однократный box-фильтр размером (2 * radius + 1) по обоим направлениям
+class BoxBlur
+{
+public:
+    BoxBlur(int radius, int numThreads)
+            : m_radius(radius),
+              m_engine(numThreads)
+    {}
+
+    bool Apply(cv::Mat& image, std::stop_token stopToken = {})
+    {
+        m_engine.Load(image, std::move(stopToken));
+        m_engine.BoxCascade(std::array{m_radius});
+        return m_engine.Store(image);
+    }
+
+private:
+    int m_radius;
+    SeparableFilterEngine m_engine;
+};
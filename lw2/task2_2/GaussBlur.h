@@ -4,168 +4,180 @@
 #include <vector>
 #include <opencv2/opencv.hpp>
 #include <cmath>
-#include <thread>
 #include <algorithm>
-#include "ImageProcessor.h"
+#include <array>
+#include <stop_token>
+#include "PixelConversion.h"
+#include "SeparableFilterEngine.h"
+
+enum class BlurMode
+{
+    Exact,
+    // три последовательных box-фильтра на бегущих суммах, стоимость не зависит от радиуса
+    Box,
+    // оба прохода в одной плитке: горизонтально размытые строки живут в кольцевом буфере и не покидают кэш
+    Fused,
+};
 
 class GaussBlur
 {
 public:
-    static const constexpr float GAMMA = 2.2f;
+    static const constexpr float GAMMA = WorkingSpace::GAMMA;
+    static const constexpr int BOX_PASSES = 3;
 
-    GaussBlur(int radius, int numThreads) : m_radius(radius), m_numThreads(numThreads)
+    GaussBlur(int radius, int numThreads, BlurMode mode = BlurMode::Exact)
+            : m_radius(radius),
+              m_mode(mode),
+              m_engine(numThreads)
     {
         m_sigma = GaussBlur::CalculateSigma(radius);
-        m_kernel = GaussBlur::GenerateGaussianKernel(m_radius, m_sigma);
+        UpdateKernels();
     }
 
-    void Apply(cv::Mat& image)
+    // 8U, 16U или 32F с 1, 3 или 4 каналами (четвертый — альфа), результат того же типа;
+    // гамма и оба прохода считаются во float без промежуточного округления;
+    // при запросе остановки возвращает false, изображение остается нетронутым
+    bool Apply(cv::Mat& image, std::stop_token stopToken = {})
     {
-        GaussBlur::ApplyGammaCorrection(image, GaussBlur::GAMMA);
-
-        ApplyGaussianBlur(image, m_kernel, true);
-        ApplyGaussianBlur(image, m_kernel, false);
+        m_engine.Load(image, std::move(stopToken));
+        Convolve();
+        return m_engine.Store(image);
+    }
 
-        GaussBlur::ApplyGammaCorrection(image, 1.0f / GaussBlur::GAMMA);
+    // то же для каналов, уже разложенных по отдельным плоскостям одного размера и глубины
+    bool Apply(std::vector<cv::Mat>& planes, std::stop_token stopToken = {})
+    {
+        m_engine.Load(planes, std::move(stopToken));
+        Convolve();
+        return m_engine.Store(planes);
     }
 
     void SetRadius(int radius)
     {
         m_radius = radius;
-        m_kernel = GaussBlur::GenerateGaussianKernel(m_radius, m_sigma);
+        m_sigma = GaussBlur::CalculateSigma(radius);
+        UpdateKernels();
     }
 
-    //вынести в отдельный класс
-    static void ShowInteractiveBlur(const std::string& imagePath)
+    [[nodiscard]] int GetRadius() const noexcept
     {
-        cv::Mat image = ImageProcessor::LoadImage(imagePath);
-        int radius = 10;
-        GaussBlur gaussBlur(radius, 12);
-
-        auto onTrackbar = [](int pos, void* userdata) {
-            auto* data = static_cast<std::pair<cv::Mat, GaussBlur*>*>(userdata);
-            cv::Mat& img = data->first;
-            GaussBlur* gaussBlur = data->second;
-
-            gaussBlur->SetRadius(pos);
-            gaussBlur->Apply(img);
-            cv::imshow("Gaussian Blur", img);
-        };
-
-        cv::namedWindow("Gaussian Blur", cv::WINDOW_NORMAL);
-        std::pair<cv::Mat, GaussBlur*> userdata = {image, &gaussBlur};
-        cv::createTrackbar("Radius", "Gaussian Blur", nullptr, 500, onTrackbar, &userdata);
-        onTrackbar(radius, &userdata);
-        cv::waitKey(0);
+        return m_radius;
+    }
+
+    void SetMode(BlurMode mode)
+    {
+        m_mode = mode;
+    }
+
+    // нормированное ядро гаусса с той же sigma, что выбирается для радиуса в GaussBlur
+    static std::vector<float> CreateKernel(int radius)
+    {
+        return GaussBlur::GenerateGaussianKernel(radius, GaussBlur::CalculateSigma(radius));
+    }
+
+    // максимальное отклонение одномерного отклика каскада box-фильтров от точного ядра, в долях от пика ядра
+    [[nodiscard]] float GetApproximationError() const
+    {
+        std::vector<double> response = {1.0};
+        for (int boxRadius : m_boxRadii)
+        {
+            std::vector<double> next(response.size() + 2 * boxRadius, 0.0);
+            for (size_t i = 0; i < response.size(); ++i)
+            {
+                for (int j = 0; j <= 2 * boxRadius; ++j)
+                {
+                    next[i + j] += response[i] / (2 * boxRadius + 1);
+                }
+            }
+            response = std::move(next);
+        }
+
+        int responseRadius = static_cast<int>(response.size()) / 2;
+        int maxRadius = std::max(responseRadius, m_radius);
+        double peak = *std::max_element(m_kernel.begin(), m_kernel.end());
+        double maxError = 0.0;
+        for (int i = -maxRadius; i <= maxRadius; ++i)
+        {
+            double exact = std::abs(i) <= m_radius ? m_kernel[i + m_radius] : 0.0;
+            double approx = std::abs(i) <= responseRadius ? response[i + responseRadius] : 0.0;
+            maxError = std::max(maxError, std::abs(exact - approx));
+        }
+        return static_cast<float>(maxError / peak);
     }
 
 private:
     int m_radius;
     float m_sigma;
-    int m_numThreads;
+    BlurMode m_mode;
+    SeparableFilterEngine m_engine;
     std::vector<float> m_kernel;
+    std::array<int, BOX_PASSES> m_boxRadii{};
 
-    static float CalculateSigma(int radius)
+    void Convolve()
     {
-        return 0.3f * (static_cast<float>(radius - 1) * 0.5f - 1) + 0.8f;
+        if (m_mode == BlurMode::Box)
+        {
+            m_engine.BoxCascade(m_boxRadii);
+        }
+        else if (m_mode == BlurMode::Fused)
+        {
+            m_engine.ConvolveFused(m_kernel, m_kernel);
+        }
+        else
+        {
+            m_engine.Convolve(m_kernel, m_kernel);
+        }
     }
 
-    static std::vector<float> GenerateGaussianKernel(int radius, float sigma)
+    void UpdateKernels()
     {
-        std::vector<float> kernel(2 * radius + 1);
-        float sum = 0.0f;
+        m_kernel = GaussBlur::GenerateGaussianKernel(m_radius, m_sigma);
+        m_boxRadii = GaussBlur::CalculateBoxRadii(m_sigma);
+    }
 
-        for (int i = -radius; i <= radius; ++i)
+    // ширины box-фильтров, каскад которых дает ту же дисперсию, что и гаусс с заданной sigma
+    static std::array<int, BOX_PASSES> CalculateBoxRadii(float sigma)
+    {
+        double variance = 12.0 * sigma * sigma;
+        auto lowerWidth = static_cast<int>(std::floor(std::sqrt(variance / BOX_PASSES + 1.0)));
+        if (lowerWidth % 2 == 0)
         {
-            kernel[i + radius] = std::exp(static_cast<float>(-(i * i)) / (2.0f * sigma * sigma));
-            sum += kernel[i + radius];
+            lowerWidth--;
         }
+        int upperWidth = lowerWidth + 2;
+        auto lowerCount = static_cast<int>(std::round(
+                (variance - BOX_PASSES * lowerWidth * lowerWidth - 4.0 * BOX_PASSES * lowerWidth - 3.0 * BOX_PASSES)
+                / (-4.0 * lowerWidth - 4.0)));
 
-        for (float& k : kernel)
+        std::array<int, BOX_PASSES> radii{};
+        for (int i = 0; i < BOX_PASSES; ++i)
         {
-            k /= sum;
+            radii[i] = ((i < lowerCount ? lowerWidth : upperWidth) - 1) / 2;
         }
-
-        return kernel;
+        return radii;
     }
 
-    static void ApplyGammaCorrection(cv::Mat& image, float gamma)
+    static float CalculateSigma(int radius)
     {
-        // распараллелить
-        float invGamma = 1.0f / gamma;
-        for (int y = 0; y < image.rows; ++y)
-        {
-            for (int x = 0; x < image.cols; ++x)
-            {
-                //выполнив гамма коррекцию лучше сохранить данные во float, чтобы не терять качество
-                auto& pixel = image.at<cv::Vec3b>(y, x);
-                for (int c = 0; c < 3; ++c)
-                {
-                    float normalized = static_cast<float>(pixel[c]) / 255.0f;
-                    normalized = std::pow(normalized, invGamma);
-                    pixel[c] = static_cast<uchar>(std::round(normalized * 255));
-                }
-            }
-        }
+        return 0.3f * (static_cast<float>(radius - 1) * 0.5f - 1) + 0.8f;
     }
 
-    void ApplyGaussianBlur(cv::Mat& image, const std::vector<float>& kernel, bool isHorizontal) const
+    static std::vector<float> GenerateGaussianKernel(int radius, float sigma)
     {
-        int width = image.cols;
-        int height = image.rows;
-        int halfSize = static_cast<int>(kernel.size()) / 2;
-        cv::Mat temp = image.clone();
-
-        auto process = [&](int start, int end) {
-            //транспонировать, чтобы было быстрее
-            if (isHorizontal)
-            {
-                for (int y = start; y < end; ++y)
-                {
-                    for (int x = 0; x < width; ++x)
-                    {
-                        cv::Vec3f sum = cv::Vec3f(0, 0, 0);
-                        for (int i = -halfSize; i <= halfSize; ++i)
-                        {
-                            int ix = std::clamp(x + i, 0, width - 1);
-                            sum += kernel[i + halfSize] * cv::Vec3f(image.at<cv::Vec3b>(y, ix));
-                        }
-                        temp.at<cv::Vec3b>(y, x) = cv::Vec3b(sum);
-                    }
-                }
-            }
-            else
-            {
-                for (int x = start; x < end; ++x)
-                {
-                    for (int y = 0; y < height; ++y)
-                    {
-                        cv::Vec3f sum = cv::Vec3f(0, 0, 0);
-                        for (int i = -halfSize; i <= halfSize; ++i)
-                        {
-                            int iy = std::clamp(y + i, 0, height - 1);
-                            sum += kernel[i + halfSize] * cv::Vec3f(image.at<cv::Vec3b>(iy, x));
-                        }
-                        temp.at<cv::Vec3b>(y, x) = cv::Vec3b(sum);
-                    }
-                }
-            }
-        };
+        std::vector<float> kernel(2 * radius + 1);
+        float sum = 0.0f;
 
-        std::vector<std::jthread> threads;
-        int chunkSize = (isHorizontal ? height : width) / m_numThreads;
-        for (int i = 0; i < m_numThreads; ++i)
+        for (int i = -radius; i <= radius; ++i)
         {
-            int start = i * chunkSize;
-            int end = (i == m_numThreads - 1) ? (isHorizontal ? height : width) : (i + 1) * chunkSize;
-            threads.emplace_back(process, start, end);
+            kernel[i + radius] = std::exp(static_cast<float>(-(i * i)) / (2.0f * sigma * sigma));
+            sum += kernel[i + radius];
         }
 
-        for (auto& t : threads)
+        for (float& k : kernel)
         {
-            t.join();
+            k /= sum;
         }
 
-        image = temp.clone();
+        return kernel;
     }
 };
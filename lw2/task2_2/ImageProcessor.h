@@ -1,11 +1,16 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
 #include <opencv2/opencv.hpp>
 
 class ImageProcessor {
 public:
     static cv::Mat LoadImage(const std::string& path) {
-        cv::Mat image = cv::imread(path, cv::IMREAD_COLOR);
+        // глубина, число каналов и альфа сохраняются как в файле
+        cv::Mat image = cv::imread(path, cv::IMREAD_UNCHANGED);
         if (image.empty()) {
             throw std::runtime_error("error while loading image: " + path);
         }
@@ -13,6 +18,71 @@ public:
     }
 
     static void SaveImage(const std::string& path, const cv::Mat& image) {
-        cv::imwrite(path, image);
+        if (!cv::imwrite(path, image)) {
+            throw std::runtime_error("error while saving image: " + path);
+        }
+    }
+
+    // каталог (берутся файлы с расширениями изображений) или шаблон с * и ? в имени файла: photos/*.jpg
+    static std::vector<std::filesystem::path> ListImages(const std::string& input) {
+        std::filesystem::path path(input);
+        std::filesystem::path directory = path;
+        std::string pattern;
+        if (!std::filesystem::is_directory(path)) {
+            directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+            pattern = path.filename().string();
+        }
+        if (!std::filesystem::is_directory(directory)) {
+            throw std::runtime_error("directory does not exist: " + directory.string());
+        }
+
+        std::vector<std::filesystem::path> images;
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            if (!entry.is_regular_file()) {
+                continue;
+            }
+            std::string name = entry.path().filename().string();
+            if (pattern.empty() ? IsImageExtension(entry.path().extension().string()) : MatchesPattern(name, pattern)) {
+                images.push_back(entry.path());
+            }
+        }
+        if (images.empty()) {
+            throw std::runtime_error("no images found: " + input);
+        }
+        std::sort(images.begin(), images.end());
+        return images;
+    }
+
+private:
+    static bool IsImageExtension(std::string extension) {
+        static const std::vector<std::string> extensions = {
+                ".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff", ".webp", ".ppm", ".pgm", ".exr", ".hdr"
+        };
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+    }
+
+    static bool MatchesPattern(const std::string& name, const std::string& pattern) {
+        size_t n = 0, p = 0;
+        size_t starPos = std::string::npos, starMatch = 0;
+        while (n < name.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+                n++;
+                p++;
+            } else if (p < pattern.size() && pattern[p] == '*') {
+                starPos = p++;
+                starMatch = n;
+            } else if (starPos != std::string::npos) {
+                p = starPos + 1;
+                n = ++starMatch;
+            } else {
+                return false;
+            }
+        }
+        while (p < pattern.size() && pattern[p] == '*') {
+            p++;
+        }
+        return p == pattern.size();
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <opencv2/opencv.hpp>
+#include "BlurPreviewEngine.h"
+#include "ImageProcessor.h"
+
+// Окно с ползунком радиуса: колбэк показывает превью, цикл окна подменяет его полным результатом по готовности
+class InteractiveBlur
+{
+public:
+    static void Show(const std::string& imagePath, int numThreads)
+    {
+        cv::Mat image = ImageProcessor::LoadImage(imagePath);
+        BlurPreviewEngine engine(image, numThreads);
+
+        auto onTrackbar = [](int pos, void* userdata) {
+            auto* engine = static_cast<BlurPreviewEngine*>(userdata);
+            cv::imshow(WINDOW_NAME, engine->Request(pos));
+        };
+
+        cv::namedWindow(WINDOW_NAME, cv::WINDOW_NORMAL);
+        cv::createTrackbar(TRACKBAR_NAME, WINDOW_NAME, nullptr, MAX_RADIUS, onTrackbar, &engine);
+        cv::setTrackbarPos(TRACKBAR_NAME, WINDOW_NAME, INITIAL_RADIUS);
+        onTrackbar(INITIAL_RADIUS, &engine);
+
+        while (cv::waitKey(POLL_INTERVAL_MS) != ESCAPE_KEY
+               && cv::getWindowProperty(WINDOW_NAME, cv::WND_PROP_VISIBLE) >= 1)
+        {
+            if (auto completed = engine.TakeCompleted())
+            {
+                cv::imshow(WINDOW_NAME, *completed);
+            }
+        }
+    }
+
+private:
+    static inline const std::string WINDOW_NAME = "Gaussian Blur";
+    static inline const std::string TRACKBAR_NAME = "Radius";
+    static const constexpr int MAX_RADIUS = 500;
+    static const constexpr int INITIAL_RADIUS = 10;
+    static const constexpr int POLL_INTERVAL_MS = 30;
+    static const constexpr int ESCAPE_KEY = 27;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <fstream>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "SeparableFilterEngine.h"
+
+// Сепарабельный фильтр с ядрами пользователя. В файле одна строка весов — одно ядро для обоих направлений,
+// две строки — горизонтальное и вертикальное; веса не нормируются, длина каждого ядра нечетная
+class KernelFilter
+{
+public:
+    KernelFilter(std::vector<float> horizontal, std::vector<float> vertical, int numThreads)
+            : m_horizontal(std::move(horizontal)),
+              m_vertical(std::move(vertical)),
+              m_engine(numThreads)
+    {
+        CheckKernel(m_horizontal);
+        CheckKernel(m_vertical);
+    }
+
+    static KernelFilter FromFile(const std::string& path, int numThreads)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("failed to open kernel file: " + path);
+        }
+
+        std::vector<std::vector<float>> kernels;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream stream(line);
+            std::vector<float> kernel;
+            float weight;
+            while (stream >> weight)
+            {
+                kernel.push_back(weight);
+            }
+            if (!stream.eof())
+            {
+                throw std::runtime_error("invalid weight in kernel file: " + path);
+            }
+            if (!kernel.empty())
+            {
+                kernels.push_back(std::move(kernel));
+            }
+        }
+
+        if (kernels.empty() || kernels.size() > 2)
+        {
+            throw std::runtime_error("kernel file must contain one or two kernels: " + path);
+        }
+        return {kernels.front(), kernels.back(), numThreads};
+    }
+
+    bool Apply(cv::Mat& image, std::stop_token stopToken = {})
+    {
+        m_engine.Load(image, std::move(stopToken));
+        m_engine.ConvolveFused(m_horizontal, m_vertical);
+        return m_engine.Store(image);
+    }
+
+private:
+    std::vector<float> m_horizontal;
+    std::vector<float> m_vertical;
+    SeparableFilterEngine m_engine;
+
+    static void CheckKernel(const std::vector<float>& kernel)
+    {
+        if (kernel.size() % 2 == 0)
+        {
+            throw std::invalid_argument("kernel length must be odd");
+        }
+    }
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+struct WorkingSpace
+{
+    static const constexpr float GAMMA = 2.2f;
+    // [0, 1] рабочего пространства разбит на FROM_WORKING_LUT_SIZE отсчетов
+    static const constexpr size_t FROM_WORKING_LUT_SIZE = 1 << 16;
+};
+
+// Перевод отсчетов изображения типа T в рабочее пространство float и обратно;
+// альфа переводится линейно в [0, 1], без гаммы
+template<typename T>
+struct PixelConversion;
+
+template<>
+struct PixelConversion<uchar> : WorkingSpace
+{
+    static float ToWorking(uchar value)
+    {
+        return GetToWorkingLut()[value];
+    }
+
+    static uchar FromWorking(float value)
+    {
+        auto scale = static_cast<float>(FROM_WORKING_LUT_SIZE - 1);
+        return GetFromWorkingLut()[static_cast<size_t>(std::clamp(value, 0.0f, 1.0f) * scale + 0.5f)];
+    }
+
+    static float AlphaToWorking(uchar value)
+    {
+        return static_cast<float>(value) / 255.0f;
+    }
+
+    static uchar AlphaFromWorking(float value)
+    {
+        return static_cast<uchar>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+private:
+    // по значению на каждый возможный байт
+    static const std::array<float, 256>& GetToWorkingLut()
+    {
+        static const std::array<float, 256> lut = [] {
+            std::array<float, 256> table{};
+            for (size_t i = 0; i < table.size(); ++i)
+            {
+                table[i] = std::pow(static_cast<float>(i) / 255.0f, 1.0f / GAMMA);
+            }
+            return table;
+        }();
+        return lut;
+    }
+
+    static const std::vector<uchar>& GetFromWorkingLut()
+    {
+        static const std::vector<uchar> lut = [] {
+            std::vector<uchar> table(FROM_WORKING_LUT_SIZE);
+            for (size_t i = 0; i < table.size(); ++i)
+            {
+                float normalized = static_cast<float>(i) / static_cast<float>(FROM_WORKING_LUT_SIZE - 1);
+                table[i] = static_cast<uchar>(std::round(std::pow(normalized, GAMMA) * 255.0f));
+            }
+            return table;
+        }();
+        return lut;
+    }
+};
+
+template<>
+struct PixelConversion<ushort> : WorkingSpace
+{
+    static float ToWorking(ushort value)
+    {
+        return GetToWorkingLut()[value];
+    }
+
+    // шага таблицы не хватает для 16 бит, поэтому между ее отсчетами интерполируем линейно
+    static ushort FromWorking(float value)
+    {
+        const auto& lut = GetFromWorkingLut();
+        float position = std::clamp(value, 0.0f, 1.0f) * static_cast<float>(FROM_WORKING_LUT_SIZE);
+        auto index = std::min(static_cast<size_t>(position), FROM_WORKING_LUT_SIZE - 1);
+        float fraction = position - static_cast<float>(index);
+        float linear = lut[index] + (lut[index + 1] - lut[index]) * fraction;
+        return static_cast<ushort>(linear * 65535.0f + 0.5f);
+    }
+
+    static float AlphaToWorking(ushort value)
+    {
+        return static_cast<float>(value) / 65535.0f;
+    }
+
+    static ushort AlphaFromWorking(float value)
+    {
+        return static_cast<ushort>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    }
+
+private:
+    static const std::vector<float>& GetToWorkingLut()
+    {
+        static const std::vector<float> lut = [] {
+            std::vector<float> table(1 << 16);
+            for (size_t i = 0; i < table.size(); ++i)
+            {
+                table[i] = std::pow(static_cast<float>(i) / 65535.0f, 1.0f / GAMMA);
+            }
+            return table;
+        }();
+        return lut;
+    }
+
+    // FROM_WORKING_LUT_SIZE + 1 отсчетов, чтобы у последнего интервала был правый конец
+    static const std::vector<float>& GetFromWorkingLut()
+    {
+        static const std::vector<float> lut = [] {
+            std::vector<float> table(FROM_WORKING_LUT_SIZE + 1);
+            for (size_t i = 0; i < table.size(); ++i)
+            {
+                float normalized = static_cast<float>(i) / static_cast<float>(FROM_WORKING_LUT_SIZE);
+                table[i] = std::pow(normalized, GAMMA);
+            }
+            return table;
+        }();
+        return lut;
+    }
+};
+
+// HDR: значения выше 1 сохраняются, таблицы не годятся, считаем напрямую
+template<>
+struct PixelConversion<float> : WorkingSpace
+{
+    static float ToWorking(float value)
+    {
+        return std::pow(std::max(value, 0.0f), 1.0f / GAMMA);
+    }
+
+    static float FromWorking(float value)
+    {
+        return std::pow(std::max(value, 0.0f), GAMMA);
+    }
+
+    static float AlphaToWorking(float value)
+    {
+        return value;
+    }
+
+    static float AlphaFromWorking(float value)
+    {
+        return std::clamp(value, 0.0f, 1.0f);
+    }
+};
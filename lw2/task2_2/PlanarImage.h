@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Рабочий буфер во float, каждый канал хранится отдельной плоскостью
+class PlanarImage
+{
+public:
+    PlanarImage() = default;
+
+    PlanarImage(int width, int height, int channels)
+    {
+        Resize(width, height, channels);
+    }
+
+    void Resize(int width, int height, int channels)
+    {
+        m_width = width;
+        m_height = height;
+        m_channels = channels;
+        m_data.resize(static_cast<size_t>(width) * height * channels);
+    }
+
+    [[nodiscard]] int GetWidth() const noexcept
+    {
+        return m_width;
+    }
+
+    [[nodiscard]] int GetHeight() const noexcept
+    {
+        return m_height;
+    }
+
+    [[nodiscard]] int GetChannels() const noexcept
+    {
+        return m_channels;
+    }
+
+    float* GetRow(int channel, int y)
+    {
+        return m_data.data() + (static_cast<size_t>(channel) * m_height + y) * m_width;
+    }
+
+    [[nodiscard]] const float* GetRow(int channel, int y) const
+    {
+        return m_data.data() + (static_cast<size_t>(channel) * m_height + y) * m_width;
+    }
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    int m_channels = 0;
+    std::vector<float> m_data;
+};
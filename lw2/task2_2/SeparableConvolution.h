@@ -0,0 +1,270 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEPARABLE_CONVOLUTION_X86
+#endif
+
+// src — строка, дополненная (taps - 1) / 2 отсчетами с каждой стороны, dst[x] = sum(kernel[i] * src[x + i])
+using HorizontalKernel = void (*)(const float* src, float* dst, int width, const float* kernel, int taps);
+// rows — taps указателей на входные строки, dst[x] = sum(kernel[i] * rows[i][x])
+using VerticalKernel = void (*)(const float* const* rows, float* dst, int width, const float* kernel, int taps);
+
+// Ядра свертки над строками float, реализация выбирается по возможностям процессора при первом обращении
+class SeparableConvolution
+{
+public:
+    static HorizontalKernel GetHorizontal()
+    {
+        return GetDispatch().horizontal;
+    }
+
+    static VerticalKernel GetVertical()
+    {
+        return GetDispatch().vertical;
+    }
+
+    static const std::string& GetInstructionSet()
+    {
+        return GetDispatch().name;
+    }
+
+private:
+    struct Dispatch
+    {
+        std::string name;
+        HorizontalKernel horizontal;
+        VerticalKernel vertical;
+    };
+
+    static const Dispatch& GetDispatch()
+    {
+        static const Dispatch dispatch = [] {
+#ifdef SEPARABLE_CONVOLUTION_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+            {
+                return Dispatch{"avx512", HorizontalAvx512, VerticalAvx512};
+            }
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            {
+                return Dispatch{"avx2", HorizontalAvx2, VerticalAvx2};
+            }
+            if (__builtin_cpu_supports("sse2"))
+            {
+                return Dispatch{"sse", HorizontalSse, VerticalSse};
+            }
+#endif
+            return Dispatch{"scalar", HorizontalScalar, VerticalScalar};
+        }();
+        return dispatch;
+    }
+
+    static void HorizontalScalar(const float* src, float* dst, int width, const float* kernel, int taps)
+    {
+        HorizontalTail(src, dst, 0, width, kernel, taps);
+    }
+
+    static void VerticalScalar(const float* const* rows, float* dst, int width, const float* kernel, int taps)
+    {
+        VerticalTail(rows, dst, 0, width, kernel, taps);
+    }
+
+    // хвост строки считается с тем же округлением, что и векторная часть: IsFused — через fma, как в avx2 и avx512,
+    // иначе умножение и сложение по отдельности, как в sse. Тогда результат не зависит от того, на какие столбцы
+    // пришелся хвост, и режим Fused с его шириной полос совпадает с Exact бит в бит
+    template<bool IsFused>
+    static float MultiplyAdd(float weight, float value, float sum)
+    {
+        if constexpr (IsFused)
+        {
+            return std::fmaf(weight, value, sum);
+        }
+        else
+        {
+            return sum + weight * value;
+        }
+    }
+
+    template<bool IsFused = false>
+    static void HorizontalTail(const float* src, float* dst, int from, int width, const float* kernel, int taps)
+    {
+        for (int x = from; x < width; ++x)
+        {
+            float sum = 0.0f;
+            for (int i = 0; i < taps; ++i)
+            {
+                sum = MultiplyAdd<IsFused>(kernel[i], src[x + i], sum);
+            }
+            dst[x] = sum;
+        }
+    }
+
+    template<bool IsFused = false>
+    static void VerticalTail(const float* const* rows, float* dst, int from, int width, const float* kernel, int taps)
+    {
+        for (int x = from; x < width; ++x)
+        {
+            float sum = 0.0f;
+            for (int i = 0; i < taps; ++i)
+            {
+                sum = MultiplyAdd<IsFused>(kernel[i], rows[i][x], sum);
+            }
+            dst[x] = sum;
+        }
+    }
+
+#ifdef SEPARABLE_CONVOLUTION_X86
+    __attribute__((target("sse2")))
+    static void HorizontalSse(const float* src, float* dst, int width, const float* kernel, int taps)
+    {
+        int x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128 sum = _mm_setzero_ps();
+            for (int i = 0; i < taps; ++i)
+            {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel[i]), _mm_loadu_ps(src + x + i)));
+            }
+            _mm_storeu_ps(dst + x, sum);
+        }
+        HorizontalTail(src, dst, x, width, kernel, taps);
+    }
+
+    __attribute__((target("sse2")))
+    static void VerticalSse(const float* const* rows, float* dst, int width, const float* kernel, int taps)
+    {
+        int x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128 sum = _mm_setzero_ps();
+            for (int i = 0; i < taps; ++i)
+            {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel[i]), _mm_loadu_ps(rows[i] + x)));
+            }
+            _mm_storeu_ps(dst + x, sum);
+        }
+        VerticalTail(rows, dst, x, width, kernel, taps);
+    }
+
+    __attribute__((target("avx2,fma")))
+    static void HorizontalAvx2(const float* src, float* dst, int width, const float* kernel, int taps)
+    {
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m256 sum0 = _mm256_setzero_ps();
+            __m256 sum1 = _mm256_setzero_ps();
+            for (int i = 0; i < taps; ++i)
+            {
+                __m256 weight = _mm256_set1_ps(kernel[i]);
+                sum0 = _mm256_fmadd_ps(weight, _mm256_loadu_ps(src + x + i), sum0);
+                sum1 = _mm256_fmadd_ps(weight, _mm256_loadu_ps(src + x + i + 8), sum1);
+            }
+            _mm256_storeu_ps(dst + x, sum0);
+            _mm256_storeu_ps(dst + x + 8, sum1);
+        }
+        for (; x + 8 <= width; x += 8)
+        {
+            __m256 sum = _mm256_setzero_ps();
+            for (int i = 0; i < taps; ++i)
+            {
+                sum = _mm256_fmadd_ps(_mm256_set1_ps(kernel[i]), _mm256_loadu_ps(src + x + i), sum);
+            }
+            _mm256_storeu_ps(dst + x, sum);
+        }
+        HorizontalTail<true>(src, dst, x, width, kernel, taps);
+    }
+
+    __attribute__((target("avx2,fma")))
+    static void VerticalAvx2(const float* const* rows, float* dst, int width, const float* kernel, int taps)
+    {
+        int x = 0;
+        // два вектора за итерацию, чтобы спрятать задержку fma
+        for (; x + 16 <= width; x += 16)
+        {
+            __m256 sum0 = _mm256_setzero_ps();
+            __m256 sum1 = _mm256_setzero_ps();
+            for (int i = 0; i < taps; ++i)
+            {
+                __m256 weight = _mm256_set1_ps(kernel[i]);
+                sum0 = _mm256_fmadd_ps(weight, _mm256_loadu_ps(rows[i] + x), sum0);
+                sum1 = _mm256_fmadd_ps(weight, _mm256_loadu_ps(rows[i] + x + 8), sum1);
+            }
+            _mm256_storeu_ps(dst + x, sum0);
+            _mm256_storeu_ps(dst + x + 8, sum1);
+        }
+        for (; x + 8 <= width; x += 8)
+        {
+            __m256 sum = _mm256_setzero_ps();
+            for (int i = 0; i < taps; ++i)
+            {
+                sum = _mm256_fmadd_ps(_mm256_set1_ps(kernel[i]), _mm256_loadu_ps(rows[i] + x), sum);
+            }
+            _mm256_storeu_ps(dst + x, sum);
+        }
+        VerticalTail<true>(rows, dst, x, width, kernel, taps);
+    }
+
+    __attribute__((target("avx512f")))
+    static void HorizontalAvx512(const float* src, float* dst, int width, const float* kernel, int taps)
+    {
+        int x = 0;
+        for (; x + 32 <= width; x += 32)
+        {
+            __m512 sum0 = _mm512_setzero_ps();
+            __m512 sum1 = _mm512_setzero_ps();
+            for (int i = 0; i < taps; ++i)
+            {
+                __m512 weight = _mm512_set1_ps(kernel[i]);
+                sum0 = _mm512_fmadd_ps(weight, _mm512_loadu_ps(src + x + i), sum0);
+                sum1 = _mm512_fmadd_ps(weight, _mm512_loadu_ps(src + x + i + 16), sum1);
+            }
+            _mm512_storeu_ps(dst + x, sum0);
+            _mm512_storeu_ps(dst + x + 16, sum1);
+        }
+        for (; x + 16 <= width; x += 16)
+        {
+            __m512 sum = _mm512_setzero_ps();
+            for (int i = 0; i < taps; ++i)
+            {
+                sum = _mm512_fmadd_ps(_mm512_set1_ps(kernel[i]), _mm512_loadu_ps(src + x + i), sum);
+            }
+            _mm512_storeu_ps(dst + x, sum);
+        }
+        HorizontalTail<true>(src, dst, x, width, kernel, taps);
+    }
+
+    __attribute__((target("avx512f")))
+    static void VerticalAvx512(const float* const* rows, float* dst, int width, const float* kernel, int taps)
+    {
+        int x = 0;
+        for (; x + 32 <= width; x += 32)
+        {
+            __m512 sum0 = _mm512_setzero_ps();
+            __m512 sum1 = _mm512_setzero_ps();
+            for (int i = 0; i < taps; ++i)
+            {
+                __m512 weight = _mm512_set1_ps(kernel[i]);
+                sum0 = _mm512_fmadd_ps(weight, _mm512_loadu_ps(rows[i] + x), sum0);
+                sum1 = _mm512_fmadd_ps(weight, _mm512_loadu_ps(rows[i] + x + 16), sum1);
+            }
+            _mm512_storeu_ps(dst + x, sum0);
+            _mm512_storeu_ps(dst + x + 16, sum1);
+        }
+        for (; x + 16 <= width; x += 16)
+        {
+            __m512 sum = _mm512_setzero_ps();
+            for (int i = 0; i < taps; ++i)
+            {
+                sum = _mm512_fmadd_ps(_mm512_set1_ps(kernel[i]), _mm512_loadu_ps(rows[i] + x), sum);
+            }
+            _mm512_storeu_ps(dst + x, sum);
+        }
+        VerticalTail<true>(rows, dst, x, width, kernel, taps);
+    }
+#endif
+};
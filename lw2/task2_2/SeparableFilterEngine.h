@@ -0,0 +1,566 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <stop_token>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "PixelConversion.h"
+#include "PlanarImage.h"
+#include "SeparableConvolution.h"
+#include "ThreadPool.h"
+
+// Общая часть сепарабельных фильтров: перевод в рабочее пространство, потоки, плитки, дополнение краев
+// и SIMD-свертка. Фильтр загружает изображение, выполняет проходы над рабочим буфером и выгружает результат
+class SeparableFilterEngine
+{
+public:
+    // вызывается для каждого отрезка строки сразу после вертикальной свертки, пока он в кэше;
+    // isAlpha — отрезок из плоскости альфы, цветовые плоскости в этот момент домножены на нее
+    using RowEpilogue = std::function<void(const float* source, float* result, int width, bool isAlpha)>;
+
+    explicit SeparableFilterEngine(int numThreads)
+            : m_pool(numThreads),
+              m_scratch(m_pool.GetNumThreads())
+    {}
+
+    [[nodiscard]] int GetNumThreads() const noexcept
+    {
+        return m_pool.GetNumThreads();
+    }
+
+    // 8U, 16U или 32F с 1, 3 или 4 каналами (четвертый — альфа);
+    // stopToken действует до следующей загрузки, после остановки оставшиеся плитки пропускаются
+    void Load(const cv::Mat& image, std::stop_token stopToken = {})
+    {
+        m_stopToken = std::move(stopToken);
+        ToWorking(image, m_working);
+        m_temp.Resize(m_working.GetWidth(), m_working.GetHeight(), m_working.GetChannels());
+    }
+
+    // пишет результат в изображение того же размера и типа, что было загружено;
+    // при запросе остановки возвращает false, изображение остается нетронутым
+    bool Store(cv::Mat& image)
+    {
+        if (m_stopToken.stop_requested())
+        {
+            return false;
+        }
+        FromWorking(m_working, image);
+        return true;
+    }
+
+    // то же для изображения, разложенного по отдельным одноканальным плоскостям одного размера и глубины:
+    // плоскости читаются и пишутся напрямую, без сборки в чередующиеся каналы
+    void Load(const std::vector<cv::Mat>& planes, std::stop_token stopToken = {})
+    {
+        m_stopToken = std::move(stopToken);
+        ToWorking(planes, m_working);
+        m_temp.Resize(m_working.GetWidth(), m_working.GetHeight(), m_working.GetChannels());
+    }
+
+    bool Store(std::vector<cv::Mat>& planes)
+    {
+        if (m_stopToken.stop_requested())
+        {
+            return false;
+        }
+        FromWorking(m_working, planes);
+        return true;
+    }
+
+    // два полных прохода, для больших ядер вертикальный идет через транспонирование
+    void Convolve(const std::vector<float>& horizontal, const std::vector<float>& vertical)
+    {
+        ApplyHorizontal(m_working, m_temp, horizontal);
+        ApplyVertical(m_temp, m_working, vertical);
+    }
+
+    // оба прохода в одной плитке: горизонтально свернутые строки живут в кольцевом буфере и не покидают кэш
+    void ConvolveFused(const std::vector<float>& horizontal, const std::vector<float>& vertical,
+            const RowEpilogue& epilogue = nullptr)
+    {
+        ApplyFused(m_working, m_temp, horizontal, vertical, epilogue);
+        std::swap(m_working, m_temp);
+    }
+
+    // каскад box-фильтров на бегущих суммах, стоимость не зависит от радиуса
+    void BoxCascade(std::span<const int> radii)
+    {
+        ApplyBoxCascade(radii);
+    }
+
+private:
+    // плитка одного канала: строки [startY, endY), столбцы [startX, endX)
+    struct Tile
+    {
+        int channel;
+        int startY;
+        int endY;
+        int startX;
+        int endX;
+    };
+
+    // буферы потока пула, переиспользуются между проходами и изображениями одного размера
+    struct WorkerScratch
+    {
+        std::vector<float> padded;
+        std::vector<const float*> rows;
+        std::vector<double> sums;
+        std::vector<float> ring;
+    };
+
+    ThreadPool m_pool;
+    std::vector<WorkerScratch> m_scratch;
+    PlanarImage m_working;
+    PlanarImage m_temp;
+    PlanarImage m_transposed;
+    PlanarImage m_transposedBlurred;
+    std::stop_token m_stopToken;
+
+    enum class VerticalPass
+    {
+        RowStreaming,
+        Transposed,
+    };
+
+    // у полностью прозрачных пикселей цвет после размытия не определен и обнуляется
+    static const constexpr float MIN_ALPHA = 1e-6f;
+    static const constexpr size_t L2_CACHE_BYTES = 256 * 1024;
+    static const constexpr int VERTICAL_STRIP_WIDTH = 256;
+    static const constexpr int TRANSPOSE_BLOCK = 64;
+    static const constexpr int TILE_ROWS = 64;
+    static const constexpr int MIN_FUSED_STRIP_WIDTH = 64;
+
+    template<typename Func>
+    void ForEachTile(int width, int height, int channels, int tileWidth, int tileHeight, Func&& func)
+    {
+        int tilesX = (width + tileWidth - 1) / tileWidth;
+        int tilesY = (height + tileHeight - 1) / tileHeight;
+
+        m_pool.ParallelFor(tilesX * tilesY * channels, [&](int index, int worker) {
+            // после отмены оставшиеся плитки пропускаются, проходы доходят до конца вхолостую
+            if (m_stopToken.stop_requested())
+            {
+                return;
+            }
+            int channel = index / (tilesX * tilesY);
+            int tileY = index % (tilesX * tilesY) / tilesX;
+            int tileX = index % tilesX;
+            Tile tile{
+                    channel,
+                    tileY * tileHeight, std::min((tileY + 1) * tileHeight, height),
+                    tileX * tileWidth, std::min((tileX + 1) * tileWidth, width)
+            };
+            func(tile, m_scratch[worker]);
+        });
+    }
+
+    void ToWorking(const cv::Mat& image, PlanarImage& working)
+    {
+        CheckChannels(image.channels());
+        VisitDepth(image.depth(), [&]<typename T>(T) {
+            int channels = image.channels();
+            ToWorking<T>(image.cols, image.rows, channels, channels,
+                    [&](int c, int y) { return image.ptr<T>(y) + c; }, working);
+        });
+    }
+
+    void ToWorking(const std::vector<cv::Mat>& planes, PlanarImage& working)
+    {
+        CheckPlanes(planes);
+        VisitDepth(planes[0].depth(), [&]<typename T>(T) {
+            ToWorking<T>(planes[0].cols, planes[0].rows, static_cast<int>(planes.size()), 1,
+                    [&](int c, int y) { return planes[c].ptr<T>(y); }, working);
+        });
+    }
+
+    void FromWorking(const PlanarImage& working, cv::Mat& image)
+    {
+        VisitDepth(image.depth(), [&]<typename T>(T) {
+            FromWorking<T>(working, image.cols, image.rows, image.channels(),
+                    [&](int c, int y) { return image.ptr<T>(y) + c; });
+        });
+    }
+
+    void FromWorking(const PlanarImage& working, std::vector<cv::Mat>& planes)
+    {
+        VisitDepth(planes[0].depth(), [&]<typename T>(T) {
+            FromWorking<T>(working, planes[0].cols, planes[0].rows, 1,
+                    [&](int c, int y) { return planes[c].ptr<T>(y); });
+        });
+    }
+
+    // вызывает func со значением типа отсчета, соответствующего глубине
+    template<typename Func>
+    static void VisitDepth(int depth, Func&& func)
+    {
+        switch (depth)
+        {
+        case CV_8U:
+            func(uchar{});
+            break;
+        case CV_16U:
+            func(ushort{});
+            break;
+        case CV_32F:
+            func(float{});
+            break;
+        default:
+            throw std::invalid_argument("unsupported image depth, expected 8U, 16U or 32F");
+        }
+    }
+
+    static void CheckChannels(int channels)
+    {
+        if (channels != 1 && channels != 3 && channels != 4)
+        {
+            throw std::invalid_argument("unsupported number of channels, expected 1, 3 or 4");
+        }
+    }
+
+    static void CheckPlanes(const std::vector<cv::Mat>& planes)
+    {
+        CheckChannels(static_cast<int>(planes.size()));
+        for (const cv::Mat& plane : planes)
+        {
+            if (plane.channels() != 1 || plane.size() != planes[0].size() || plane.depth() != planes[0].depth())
+            {
+                throw std::invalid_argument("planes must be single-channel images of the same size and depth");
+            }
+        }
+    }
+
+    // rowOf(c, y) — первый отсчет канала c в строке y, соседние отсчеты канала через step элементов:
+    // у чередующихся каналов step равен их числу, у отдельных плоскостей — 1.
+    // Цвет с альфой домножается на нее, иначе прозрачные пиксели размазывают свой цвет по соседям
+    template<typename T, typename RowOf>
+    void ToWorking(int width, int height, int channels, int step, RowOf&& rowOf, PlanarImage& working)
+    {
+        using Conversion = PixelConversion<T>;
+        int colorChannels = channels == 4 ? 3 : channels;
+        working.Resize(width, height, channels);
+
+        ForEachTile(width, height, 1, width, TILE_ROWS, [&](const Tile& tile, WorkerScratch&) {
+            for (int y = tile.startY; y < tile.endY; ++y)
+            {
+                float* alphaRow = channels == 4 ? working.GetRow(3, y) : nullptr;
+                if (alphaRow)
+                {
+                    const T* alpha = rowOf(3, y);
+                    for (int x = 0; x < width; ++x)
+                    {
+                        alphaRow[x] = Conversion::AlphaToWorking(alpha[x * step]);
+                    }
+                }
+                for (int c = 0; c < colorChannels; ++c)
+                {
+                    const T* source = rowOf(c, y);
+                    float* row = working.GetRow(c, y);
+                    for (int x = 0; x < width; ++x)
+                    {
+                        row[x] = Conversion::ToWorking(source[x * step]);
+                    }
+                    if (alphaRow)
+                    {
+                        for (int x = 0; x < width; ++x)
+                        {
+                            row[x] *= alphaRow[x];
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    template<typename T, typename RowOf>
+    void FromWorking(const PlanarImage& working, int width, int height, int step, RowOf&& rowOf)
+    {
+        using Conversion = PixelConversion<T>;
+        int channels = working.GetChannels();
+
+        ForEachTile(width, height, 1, width, TILE_ROWS, [&](const Tile& tile, WorkerScratch&) {
+            for (int y = tile.startY; y < tile.endY; ++y)
+            {
+                if (channels == 4)
+                {
+                    const float* alphaRow = working.GetRow(3, y);
+                    std::array<T*, 4> results{rowOf(0, y), rowOf(1, y), rowOf(2, y), rowOf(3, y)};
+                    for (int x = 0; x < width; ++x)
+                    {
+                        float inverseAlpha = alphaRow[x] > MIN_ALPHA ? 1.0f / alphaRow[x] : 0.0f;
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            results[c][x * step] = Conversion::FromWorking(working.GetRow(c, y)[x] * inverseAlpha);
+                        }
+                        results[3][x * step] = Conversion::AlphaFromWorking(alphaRow[x]);
+                    }
+                    continue;
+                }
+                for (int c = 0; c < channels; ++c)
+                {
+                    const float* row = working.GetRow(c, y);
+                    T* result = rowOf(c, y);
+                    for (int x = 0; x < width; ++x)
+                    {
+                        result[x * step] = Conversion::FromWorking(row[x]);
+                    }
+                }
+            }
+        });
+    }
+
+    void ApplyBoxCascade(std::span<const int> radii)
+    {
+        // проходы по очереди пишут то в m_temp, то в m_working, результат оказывается в m_working
+        PlanarImage* src = &m_working;
+        PlanarImage* dst = &m_temp;
+        for (int boxRadius : radii)
+        {
+            ApplyBoxHorizontal(*src, *dst, boxRadius);
+            std::swap(src, dst);
+        }
+        for (int boxRadius : radii)
+        {
+            ApplyBoxVertical(*src, *dst, boxRadius);
+            std::swap(src, dst);
+        }
+        if (src != &m_working)
+        {
+            std::swap(m_working, m_temp);
+        }
+    }
+
+    void ApplyBoxHorizontal(const PlanarImage& src, PlanarImage& dst, int boxRadius)
+    {
+        int width = src.GetWidth();
+        int boxSize = 2 * boxRadius + 1;
+        double norm = 1.0 / boxSize;
+
+        ForEachTile(width, src.GetHeight(), src.GetChannels(), width, TILE_ROWS,
+                [&](const Tile& tile, WorkerScratch& scratch) {
+                    std::vector<float>& padded = scratch.padded;
+                    padded.resize(width + 2 * boxRadius);
+                    for (int y = tile.startY; y < tile.endY; ++y)
+                    {
+                        const float* srcRow = src.GetRow(tile.channel, y);
+                        float* dstRow = dst.GetRow(tile.channel, y);
+                        std::fill(padded.begin(), padded.begin() + boxRadius, srcRow[0]);
+                        std::copy(srcRow, srcRow + width, padded.begin() + boxRadius);
+                        std::fill(padded.end() - boxRadius, padded.end(), srcRow[width - 1]);
+
+                        double sum = std::accumulate(padded.begin(), padded.begin() + boxSize, 0.0);
+                        for (int x = 0; x < width; ++x)
+                        {
+                            dstRow[x] = static_cast<float>(sum * norm);
+                            if (x + 1 < width)
+                            {
+                                sum += padded[x + boxSize] - padded[x];
+                            }
+                        }
+                    }
+                });
+    }
+
+    void ApplyBoxVertical(const PlanarImage& src, PlanarImage& dst, int boxRadius)
+    {
+        int height = src.GetHeight();
+        double norm = 1.0 / (2 * boxRadius + 1);
+        int tileHeight = std::max(TILE_ROWS, 4 * boxRadius);
+
+        ForEachTile(src.GetWidth(), height, src.GetChannels(), VERTICAL_STRIP_WIDTH, tileHeight,
+                [&](const Tile& tile, WorkerScratch& scratch) {
+                    // бегущие суммы по столбцам полосы, окно сдвигается вниз на строку за шаг
+                    int stripWidth = tile.endX - tile.startX;
+                    std::vector<double>& sums = scratch.sums;
+                    sums.assign(stripWidth, 0.0);
+                    for (int i = -boxRadius; i <= boxRadius; ++i)
+                    {
+                        const float* row = src.GetRow(tile.channel, std::clamp(tile.startY + i, 0, height - 1));
+                        for (int x = 0; x < stripWidth; ++x)
+                        {
+                            sums[x] += row[tile.startX + x];
+                        }
+                    }
+
+                    for (int y = tile.startY; y < tile.endY; ++y)
+                    {
+                        float* dstRow = dst.GetRow(tile.channel, y) + tile.startX;
+                        for (int x = 0; x < stripWidth; ++x)
+                        {
+                            dstRow[x] = static_cast<float>(sums[x] * norm);
+                        }
+
+                        const float* added = src.GetRow(tile.channel, std::min(y + boxRadius + 1, height - 1));
+                        const float* removed = src.GetRow(tile.channel, std::max(y - boxRadius, 0));
+                        for (int x = 0; x < stripWidth; ++x)
+                        {
+                            sums[x] += added[tile.startX + x] - removed[tile.startX + x];
+                        }
+                    }
+                });
+    }
+
+    static VerticalPass ChooseVerticalPass(int width, int height, int taps)
+    {
+        // пока окно из taps строк полосы помещается в L2, строки переиспользуются из кэша при сдвиге окна;
+        // иначе каждая загрузка идет из памяти и дешевле транспонировать и пройти по строкам
+        size_t planeBytes = static_cast<size_t>(width) * height * sizeof(float);
+        size_t windowBytes = static_cast<size_t>(taps) * VERTICAL_STRIP_WIDTH * sizeof(float);
+        if (planeBytes <= L2_CACHE_BYTES || windowBytes <= L2_CACHE_BYTES)
+        {
+            return VerticalPass::RowStreaming;
+        }
+        return VerticalPass::Transposed;
+    }
+
+    void ApplyHorizontal(const PlanarImage& src, PlanarImage& dst, const std::vector<float>& kernel)
+    {
+        int width = src.GetWidth();
+        int taps = static_cast<int>(kernel.size());
+        int halfSize = taps / 2;
+        HorizontalKernel convolve = SeparableConvolution::GetHorizontal();
+
+        ForEachTile(width, src.GetHeight(), src.GetChannels(), width, TILE_ROWS,
+                [&](const Tile& tile, WorkerScratch& scratch) {
+                    // края дополняются один раз на строку, а не через clamp на каждый отсчет
+                    std::vector<float>& padded = scratch.padded;
+                    padded.resize(width + 2 * halfSize);
+                    for (int y = tile.startY; y < tile.endY; ++y)
+                    {
+                        const float* srcRow = src.GetRow(tile.channel, y);
+                        std::fill(padded.begin(), padded.begin() + halfSize, srcRow[0]);
+                        std::copy(srcRow, srcRow + width, padded.begin() + halfSize);
+                        std::fill(padded.end() - halfSize, padded.end(), srcRow[width - 1]);
+                        convolve(padded.data(), dst.GetRow(tile.channel, y), width, kernel.data(), taps);
+                    }
+                });
+    }
+
+    void ApplyVertical(const PlanarImage& src, PlanarImage& dst, const std::vector<float>& kernel)
+    {
+        int taps = static_cast<int>(kernel.size());
+        if (ChooseVerticalPass(src.GetWidth(), src.GetHeight(), taps) == VerticalPass::Transposed)
+        {
+            m_transposed.Resize(src.GetHeight(), src.GetWidth(), src.GetChannels());
+            m_transposedBlurred.Resize(src.GetHeight(), src.GetWidth(), src.GetChannels());
+
+            Transpose(src, m_transposed);
+            ApplyHorizontal(m_transposed, m_transposedBlurred, kernel);
+            Transpose(m_transposedBlurred, dst);
+            return;
+        }
+
+        int height = src.GetHeight();
+        int halfSize = taps / 2;
+        int tileHeight = std::max(TILE_ROWS, 2 * taps);
+        VerticalKernel convolve = SeparableConvolution::GetVertical();
+
+        ForEachTile(src.GetWidth(), height, src.GetChannels(), VERTICAL_STRIP_WIDTH, tileHeight,
+                [&](const Tile& tile, WorkerScratch& scratch) {
+                    // полоса столбцов идет сверху вниз, окно из taps отрезков строк остается в кэше
+                    std::vector<const float*>& rows = scratch.rows;
+                    rows.resize(taps);
+                    for (int y = tile.startY; y < tile.endY; ++y)
+                    {
+                        for (int i = 0; i < taps; ++i)
+                        {
+                            rows[i] = src.GetRow(tile.channel, std::clamp(y + i - halfSize, 0, height - 1))
+                                      + tile.startX;
+                        }
+                        convolve(rows.data(), dst.GetRow(tile.channel, y) + tile.startX, tile.endX - tile.startX,
+                                kernel.data(), taps);
+                    }
+                });
+    }
+
+    // ширина полосы, при которой кольцо из taps строк занимает не больше половины L2
+    static int CalculateFusedStripWidth(int width, int taps)
+    {
+        auto stripWidth = static_cast<int>(L2_CACHE_BYTES / 2 / (static_cast<size_t>(taps) * sizeof(float)));
+        stripWidth = std::max(MIN_FUSED_STRIP_WIDTH, stripWidth / 16 * 16);
+        return std::min(stripWidth, width);
+    }
+
+    void ApplyFused(const PlanarImage& src, PlanarImage& dst, const std::vector<float>& horizontal,
+            const std::vector<float>& vertical, const RowEpilogue& epilogue)
+    {
+        int width = src.GetWidth();
+        int height = src.GetHeight();
+        int horizontalHalfSize = static_cast<int>(horizontal.size()) / 2;
+        int taps = static_cast<int>(vertical.size());
+        int halfSize = taps / 2;
+        int stripWidth = CalculateFusedStripWidth(width, taps);
+        // строки ореола размываются по горизонтали в каждой плитке заново, высокая плитка снижает эту долю
+        int tileHeight = std::max(TILE_ROWS, 4 * taps);
+        HorizontalKernel convolveHorizontal = SeparableConvolution::GetHorizontal();
+        VerticalKernel convolveVertical = SeparableConvolution::GetVertical();
+
+        ForEachTile(width, height, src.GetChannels(), stripWidth, tileHeight,
+                [&](const Tile& tile, WorkerScratch& scratch) {
+                    int tileWidth = tile.endX - tile.startX;
+                    std::vector<float>& padded = scratch.padded;
+                    std::vector<float>& ring = scratch.ring;
+                    std::vector<const float*>& rows = scratch.rows;
+                    padded.resize(tileWidth + 2 * horizontalHalfSize);
+                    ring.resize(static_cast<size_t>(taps) * tileWidth);
+                    rows.resize(taps);
+
+                    // строка v (с учетом выхода за край) хранится в ячейке кольца (v - firstRow) % taps
+                    int firstRow = tile.startY - halfSize;
+                    auto ringRow = [&](int v) {
+                        return ring.data() + static_cast<size_t>((v - firstRow) % taps) * tileWidth;
+                    };
+                    auto blurRow = [&](int v) {
+                        const float* srcRow = src.GetRow(tile.channel, std::clamp(v, 0, height - 1));
+                        int from = tile.startX - horizontalHalfSize;
+                        int copyBegin = std::max(from, 0);
+                        int copyEnd = std::min(from + static_cast<int>(padded.size()), width);
+                        std::fill(padded.begin(), padded.begin() + (copyBegin - from), srcRow[0]);
+                        std::copy(srcRow + copyBegin, srcRow + copyEnd, padded.begin() + (copyBegin - from));
+                        std::fill(padded.begin() + (copyEnd - from), padded.end(), srcRow[width - 1]);
+                        convolveHorizontal(padded.data(), ringRow(v), tileWidth, horizontal.data(),
+                                static_cast<int>(horizontal.size()));
+                    };
+
+                    for (int v = firstRow; v < firstRow + taps - 1; ++v)
+                    {
+                        blurRow(v);
+                    }
+                    for (int y = tile.startY; y < tile.endY; ++y)
+                    {
+                        blurRow(y + halfSize);
+                        for (int i = 0; i < taps; ++i)
+                        {
+                            rows[i] = ringRow(y + i - halfSize);
+                        }
+                        float* dstRow = dst.GetRow(tile.channel, y) + tile.startX;
+                        convolveVertical(rows.data(), dstRow, tileWidth, vertical.data(), taps);
+                        if (epilogue)
+                        {
+                            epilogue(src.GetRow(tile.channel, y) + tile.startX, dstRow, tileWidth,
+                                    src.GetChannels() == 4 && tile.channel == 3);
+                        }
+                    }
+                });
+    }
+
+    // плитки TRANSPOSE_BLOCK x TRANSPOSE_BLOCK читаются и пишутся в пределах кэша
+    void Transpose(const PlanarImage& src, PlanarImage& dst)
+    {
+        ForEachTile(src.GetWidth(), src.GetHeight(), src.GetChannels(), TRANSPOSE_BLOCK, TRANSPOSE_BLOCK,
+                [&](const Tile& tile, WorkerScratch&) {
+                    for (int y = tile.startY; y < tile.endY; ++y)
+                    {
+                        const float* srcRow = src.GetRow(tile.channel, y);
+                        for (int x = tile.startX; x < tile.endX; ++x)
+                        {
+                            dst.GetRow(tile.channel, x)[y] = srcRow[x];
+                        }
+                    }
+                });
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "GaussBlur.h"
+
+// сырой файл без заголовка: плоскости каналов подряд, в каждой height строк по width отсчетов
+struct RawImageFormat
+{
+    int width = 0;
+    int height = 0;
+    int channels = 1;
+    int depth = CV_8U;
+};
+
+// Размытие файла, который не помещается в память: полосы строк читаются с ореолом в radius строк,
+// размываются и записываются; в памяти одновременно только width x (высота полосы + 2 * radius)
+class StreamingBlur
+{
+public:
+    static const constexpr int DEFAULT_STRIP_ROWS = 256;
+
+    explicit StreamingBlur(GaussBlur& blur, int stripRows = DEFAULT_STRIP_ROWS)
+            : m_blur(blur),
+              m_stripRows(stripRows)
+    {}
+
+    void Apply(const std::string& inputPath, const std::string& outputPath, const RawImageFormat& format)
+    {
+        // проверяется до открытия выходного файла, чтобы неподдерживаемый формат не обнулил его
+        if (format.width <= 0 || format.height <= 0)
+        {
+            throw std::invalid_argument("raw image dimensions must be positive");
+        }
+        if (format.channels != 1 && format.channels != 3 && format.channels != 4)
+        {
+            throw std::invalid_argument("unsupported number of channels, expected 1, 3 or 4");
+        }
+        if (format.depth != CV_8U && format.depth != CV_16U && format.depth != CV_32F)
+        {
+            throw std::invalid_argument("unsupported image depth, expected 8U, 16U or 32F");
+        }
+
+        size_t rowBytes = static_cast<size_t>(format.width) * CV_ELEM_SIZE1(format.depth);
+        size_t planeBytes = rowBytes * format.height;
+        if (std::filesystem::file_size(inputPath) != planeBytes * format.channels)
+        {
+            throw std::runtime_error("raw image size does not match the given dimensions: " + inputPath);
+        }
+        // полосы читаются из входного файла до самого конца, а выходной при открытии обнуляется
+        if (std::filesystem::exists(outputPath) && std::filesystem::equivalent(inputPath, outputPath))
+        {
+            throw std::invalid_argument("output file must differ from the input file: " + outputPath);
+        }
+
+        std::ifstream input(inputPath, std::ios::binary);
+        std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+        if (!input || !output)
+        {
+            throw std::runtime_error("failed to open raw image files");
+        }
+
+        // ореол пересчитывается в каждой полосе, поэтому полоса не ниже двух радиусов
+        int radius = m_blur.GetRadius();
+        int stripRows = std::max(m_stripRows, 2 * radius);
+        std::vector<cv::Mat> planes(format.channels);
+
+        for (int startY = 0; startY < format.height; startY += stripRows)
+        {
+            int endY = std::min(startY + stripRows, format.height);
+            // на краях изображения ореола нет, там GaussBlur сам повторяет крайнюю строку
+            int haloStartY = std::max(startY - radius, 0);
+            int haloEndY = std::min(endY + radius, format.height);
+
+            for (int c = 0; c < format.channels; ++c)
+            {
+                planes[c].create(haloEndY - haloStartY, format.width, format.depth);
+                input.seekg(static_cast<std::streamoff>(planeBytes * c + rowBytes * haloStartY));
+                input.read(reinterpret_cast<char*>(planes[c].data),
+                        static_cast<std::streamsize>(rowBytes * (haloEndY - haloStartY)));
+            }
+            if (!input)
+            {
+                throw std::runtime_error("failed to read raw image: " + inputPath);
+            }
+
+            // плоскости файла идут в рабочий буфер размытия напрямую, без сборки в чередующиеся каналы
+            m_blur.Apply(planes);
+
+            for (int c = 0; c < format.channels; ++c)
+            {
+                output.seekp(static_cast<std::streamoff>(planeBytes * c + rowBytes * startY));
+                output.write(reinterpret_cast<const char*>(planes[c].ptr(startY - haloStartY)),
+                        static_cast<std::streamsize>(rowBytes * (endY - startY)));
+            }
+            if (!output)
+            {
+                throw std::runtime_error("failed to write raw image: " + outputPath);
+            }
+        }
+    }
+
+private:
+    GaussBlur& m_blur;
+    int m_stripRows;
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Постоянные потоки для ParallelFor, вызывающий поток работает наравне с ними
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int numThreads) : m_numThreads(std::max(1, numThreads))
+    {
+        for (int worker = 1; worker < m_numThreads; ++worker)
+        {
+            m_workers.emplace_back([this, worker](std::stop_token stopToken) {
+                WorkerLoop(stopToken, worker);
+            });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        for (auto& worker : m_workers)
+        {
+            worker.request_stop();
+        }
+        m_wakeCondition.notify_all();
+    }
+
+    [[nodiscard]] int GetNumThreads() const noexcept
+    {
+        return m_numThreads;
+    }
+
+    // вызывает task(index, worker) для каждого index из [0, count) и ждет завершения всех;
+    // worker из [0, GetNumThreads()) позволяет держать отдельные буферы на каждый поток
+    void ParallelFor(int count, const std::function<void(int, int)>& task)
+    {
+        if (count <= 0)
+        {
+            return;
+        }
+
+        std::lock_guard callLock(m_callMutex);
+        {
+            std::lock_guard lock(m_mutex);
+            m_task = &task;
+            m_count = count;
+            m_nextIndex.store(0);
+            m_activeWorkers = static_cast<int>(m_workers.size());
+            m_exception = nullptr;
+            m_jobId++;
+        }
+        m_wakeCondition.notify_all();
+
+        RunTasks(0);
+
+        std::unique_lock lock(m_mutex);
+        m_doneCondition.wait(lock, [this] { return m_activeWorkers == 0; });
+        m_task = nullptr;
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+private:
+    int m_numThreads;
+    std::vector<std::jthread> m_workers;
+    std::mutex m_callMutex;
+    std::mutex m_mutex;
+    std::condition_variable_any m_wakeCondition;
+    std::condition_variable m_doneCondition;
+    const std::function<void(int, int)>* m_task = nullptr;
+    int m_count = 0;
+    std::atomic<int> m_nextIndex = 0;
+    int m_activeWorkers = 0;
+    unsigned long long m_jobId = 0;
+    std::exception_ptr m_exception;
+
+    void WorkerLoop(std::stop_token stopToken, int worker)
+    {
+        unsigned long long seenJobId = 0;
+        while (true)
+        {
+            {
+                std::unique_lock lock(m_mutex);
+                if (!m_wakeCondition.wait(lock, stopToken, [&] { return m_jobId != seenJobId; }))
+                {
+                    return;
+                }
+                seenJobId = m_jobId;
+            }
+
+            RunTasks(worker);
+
+            std::lock_guard lock(m_mutex);
+            if (--m_activeWorkers == 0)
+            {
+                m_doneCondition.notify_one();
+            }
+        }
+    }
+
+    void RunTasks(int worker)
+    {
+        for (int index = m_nextIndex.fetch_add(1); index < m_count; index = m_nextIndex.fetch_add(1))
+        {
+            try
+            {
+                (*m_task)(index, worker);
+            }
+            catch (...)
+            {
+                std::lock_guard lock(m_mutex);
+                if (!m_exception)
+                {
+                    m_exception = std::current_exception();
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <stop_token>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "GaussBlur.h"
+#include "SeparableFilterEngine.h"
+
+// Повышение резкости: image + amount * (image - blur(image)); вычитание выполняется сразу за вертикальной
+// сверткой в той же плитке, размытое изображение целиком не сохраняется. Альфа не меняется:
+// усиленная на краях прозрачности, она дала бы ореолы и покрытие вне [0, 1]
+class UnsharpMask
+{
+public:
+    UnsharpMask(int radius, float amount, int numThreads)
+            : m_amount(amount),
+              m_kernel(GaussBlur::CreateKernel(radius)),
+              m_engine(numThreads)
+    {}
+
+    bool Apply(cv::Mat& image, std::stop_token stopToken = {})
+    {
+        auto sharpen = [this](const float* source, float* result, int width, bool isAlpha) {
+            if (isAlpha)
+            {
+                std::copy(source, source + width, result);
+                return;
+            }
+            for (int x = 0; x < width; ++x)
+            {
+                result[x] = source[x] + m_amount * (source[x] - result[x]);
+            }
+        };
+        m_engine.Load(image, std::move(stopToken));
+        m_engine.ConvolveFused(m_kernel, m_kernel, sharpen);
+        return m_engine.Store(image);
+    }
+
+private:
+    float m_amount;
+    std::vector<float> m_kernel;
+    SeparableFilterEngine m_engine;
+};
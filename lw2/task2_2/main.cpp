@@ -1,31 +1,100 @@
 #include <iostream>
+#include <cstdlib>
 #include <string>
+#include <thread>
 #include "GaussBlur.h"
+#include "BoxBlur.h"
+#include "UnsharpMask.h"
+#include "KernelFilter.h"
+#include "InteractiveBlur.h"
 #include "ImageProcessor.h"
+#include "BatchProcessor.h"
+#include "StreamingBlur.h"
 #include "_timer.h"
 
 const std::string COMMAND_APPLY = "apply";
 const std::string COMMAND_VISUALIZE = "visualize";
+const std::string COMMAND_BATCH = "batch";
+const std::string COMMAND_STREAM = "stream";
+const std::string COMMAND_BOX = "box";
+const std::string COMMAND_SHARPEN = "sharpen";
+const std::string COMMAND_KERNEL = "kernel";
+const std::string MODE_EXACT = "exact";
+const std::string MODE_BOX = "box";
+const std::string MODE_FUSED = "fused";
+const std::string DEPTH_8U = "8u";
+const std::string DEPTH_16U = "16u";
+const std::string DEPTH_32F = "32f";
 
 void PrintUsage()
 {
     std::cerr << "Usage:" << std::endl
-              << "  gauss apply INPUT_FILE OUTPUT_FILE RADIUS" << std::endl
-              << "  gauss visualize INPUT_FILE" << std::endl;
+              << "  gauss apply INPUT_FILE OUTPUT_FILE RADIUS NUM_THREADS [" << MODE_EXACT << "|" << MODE_BOX << "|" << MODE_FUSED << "]"
+              << std::endl
+              << "  gauss batch INPUT_DIR|PATTERN OUTPUT_DIR RADIUS NUM_THREADS [" << MODE_EXACT << "|" << MODE_BOX << "|" << MODE_FUSED << "]"
+              << std::endl
+              << "  gauss stream INPUT_RAW OUTPUT_RAW WIDTH HEIGHT CHANNELS RADIUS NUM_THREADS ["
+              << DEPTH_8U << "|" << DEPTH_16U << "|" << DEPTH_32F << "]" << std::endl
+              << "  gauss box INPUT_FILE OUTPUT_FILE RADIUS NUM_THREADS" << std::endl
+              << "  gauss sharpen INPUT_FILE OUTPUT_FILE RADIUS AMOUNT NUM_THREADS" << std::endl
+              << "  gauss kernel INPUT_FILE OUTPUT_FILE KERNEL_FILE NUM_THREADS" << std::endl
+              << "  gauss visualize INPUT_FILE [NUM_THREADS]" << std::endl;
 }
 
 struct ProgramArgs
 {
     bool isVisualize = false;
+    bool isBatch = false;
+    bool isStream = false;
+    // box, sharpen или kernel, пусто для размытия по Гауссу
+    std::string filter;
     std::string inputPath;
     std::string outputPath;
     int radius = 0;
     int numTreads = 1;
+    BlurMode mode = BlurMode::Exact;
+    RawImageFormat rawFormat;
+    float amount = 1.0f;
+    std::string kernelPath;
 };
 
+BlurMode ParseMode(const std::string& mode)
+{
+    if (mode == MODE_EXACT)
+    {
+        return BlurMode::Exact;
+    }
+    if (mode == MODE_BOX)
+    {
+        return BlurMode::Box;
+    }
+    if (mode == MODE_FUSED)
+    {
+        return BlurMode::Fused;
+    }
+    throw std::invalid_argument("unknown blur mode: " + mode);
+}
+
+int ParseDepth(const std::string& depth)
+{
+    if (depth == DEPTH_8U)
+    {
+        return CV_8U;
+    }
+    if (depth == DEPTH_16U)
+    {
+        return CV_16U;
+    }
+    if (depth == DEPTH_32F)
+    {
+        return CV_32F;
+    }
+    throw std::invalid_argument("unknown sample depth: " + depth);
+}
+
 ProgramArgs ParseArgs(int argc, char* argv[])
 {
-    if (argc < 3 || argc > 6)
+    if (argc < 3 || argc > 10)
     {
         PrintUsage();
         throw std::invalid_argument("not enough arguments provided");
@@ -33,27 +102,80 @@ ProgramArgs ParseArgs(int argc, char* argv[])
 
     ProgramArgs args;
     std::string command = argv[1];
-    if (command == COMMAND_APPLY)
+    if (command == COMMAND_APPLY || command == COMMAND_BATCH)
     {
-        if (argc != 6)
+        if (argc != 6 && argc != 7)
         {
             PrintUsage();
-            throw std::invalid_argument("invalid number of arguments for command: " + COMMAND_APPLY);
+            throw std::invalid_argument("invalid number of arguments for command: " + command);
         }
+        args.isBatch = command == COMMAND_BATCH;
         args.inputPath = argv[2];
         args.outputPath = argv[3];
         args.radius = std::stoi(argv[4]);
         args.numTreads = std::stoi(argv[5]);
+        if (argc == 7)
+        {
+            args.mode = ParseMode(argv[6]);
+        }
+    }
+    else if (command == COMMAND_STREAM)
+    {
+        if (argc != 9 && argc != 10)
+        {
+            PrintUsage();
+            throw std::invalid_argument("invalid number of arguments for command: " + COMMAND_STREAM);
+        }
+        args.isStream = true;
+        args.inputPath = argv[2];
+        args.outputPath = argv[3];
+        args.rawFormat.width = std::stoi(argv[4]);
+        args.rawFormat.height = std::stoi(argv[5]);
+        args.rawFormat.channels = std::stoi(argv[6]);
+        args.radius = std::stoi(argv[7]);
+        args.numTreads = std::stoi(argv[8]);
+        if (argc == 10)
+        {
+            args.rawFormat.depth = ParseDepth(argv[9]);
+        }
+    }
+    else if (command == COMMAND_BOX || command == COMMAND_SHARPEN || command == COMMAND_KERNEL)
+    {
+        int expectedArgc = command == COMMAND_SHARPEN ? 7 : 6;
+        if (argc != expectedArgc)
+        {
+            PrintUsage();
+            throw std::invalid_argument("invalid number of arguments for command: " + command);
+        }
+        args.filter = command;
+        args.inputPath = argv[2];
+        args.outputPath = argv[3];
+        if (command == COMMAND_KERNEL)
+        {
+            args.kernelPath = argv[4];
+        }
+        else
+        {
+            args.radius = std::stoi(argv[4]);
+        }
+        if (command == COMMAND_SHARPEN)
+        {
+            args.amount = std::stof(argv[5]);
+        }
+        args.numTreads = std::stoi(argv[expectedArgc - 1]);
     }
     else if (command == COMMAND_VISUALIZE)
     {
-        if (argc != 3)
+        if (argc != 3 && argc != 4)
         {
             PrintUsage();
             throw std::invalid_argument("invalid number of arguments for command: " + COMMAND_VISUALIZE);
         }
         args.isVisualize = true;
         args.inputPath = argv[2];
+        args.numTreads = argc == 4
+                ? std::stoi(argv[3])
+                : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
     }
     else
     {
@@ -64,23 +186,74 @@ ProgramArgs ParseArgs(int argc, char* argv[])
     return args;
 }
 
+template<typename Filter>
+void ApplyFilter(Filter& filter, const ProgramArgs& args)
+{
+    cv::Mat image = ImageProcessor::LoadImage(args.inputPath);
+    Timer timer;
+    filter.Apply(image);
+    std::cout << "Total time: " << timer.GetElapsed() << std::endl;
+    ImageProcessor::SaveImage(args.outputPath, image);
+}
+
 int main(int argc, char* argv[])
 {
+    // OpenCV по умолчанию не читает EXR; переменную можно выставить в 0 снаружи, она не перезаписывается
+    setenv("OPENCV_IO_ENABLE_OPENEXR", "1", 0);
     try
     {
         ProgramArgs args = ParseArgs(argc, argv);
 
         if (args.isVisualize)
         {
-            GaussBlur::ShowInteractiveBlur(args.inputPath);
+            InteractiveBlur::Show(args.inputPath, args.numTreads);
+        }
+        else if (args.isBatch)
+        {
+            auto inputs = ImageProcessor::ListImages(args.inputPath);
+            GaussBlur blur(args.radius, args.numTreads, args.mode);
+            BatchProcessor processor(blur);
+            BatchResult result = processor.Run(inputs, args.outputPath);
+
+            std::cout << "Processed: " << result.processed << ", failed: " << result.failed << std::endl;
+            std::cout << "Total time: " << result.seconds << std::endl;
+            std::cout << "Images per second: " << result.processed / result.seconds << std::endl;
+        }
+        else if (args.filter == COMMAND_BOX)
+        {
+            BoxBlur filter(args.radius, args.numTreads);
+            ApplyFilter(filter, args);
+        }
+        else if (args.filter == COMMAND_SHARPEN)
+        {
+            UnsharpMask filter(args.radius, args.amount, args.numTreads);
+            ApplyFilter(filter, args);
+        }
+        else if (args.filter == COMMAND_KERNEL)
+        {
+            KernelFilter filter = KernelFilter::FromFile(args.kernelPath, args.numTreads);
+            ApplyFilter(filter, args);
+        }
+        else if (args.isStream)
+        {
+            GaussBlur blur(args.radius, args.numTreads, args.mode);
+            StreamingBlur streamingBlur(blur);
+            Timer timer;
+            streamingBlur.Apply(args.inputPath, args.outputPath, args.rawFormat);
+            std::cout << "Total time: " << timer.GetElapsed() << std::endl;
         }
         else
         {
             cv::Mat image = ImageProcessor::LoadImage(args.inputPath);
-            GaussBlur blur(args.radius, args.numTreads);
+            GaussBlur blur(args.radius, args.numTreads, args.mode);
             Timer timer;
             blur.Apply(image);
             std::cout << "Total time: " << timer.GetElapsed() << std::endl;
+            if (args.mode == BlurMode::Box)
+            {
+                std::cout << "Approximation error: " << blur.GetApproximationError() * 100 << "% of kernel peak"
+                          << std::endl;
+            }
             ImageProcessor::SaveImage(args.outputPath, image);
         }
     }
@@ -0,0 +1,249 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../task3_1/Bank.h"
+#include "../task3_1/_libs/_timer.h"
+
+const std::string FLAG_QUICK = "--quick";
+const int WARMUP_REPETITIONS = 1;
+const int REPETITIONS = 5;
+// из каждых 100 операций столько читают баланс, остальные переводят деньги
+const int READS_PER_HUNDRED = 95;
+const Money INITIAL_BALANCE = 1000;
+
+// таблица для сравнения: у каждого счета свой shared_mutex, чтение под shared_lock, перевод под unique_lock
+class SharedMutexAccounts
+{
+public:
+    SharedMutexAccounts(size_t accountsCount, Money initialBalance)
+            : m_accounts(std::make_unique<Account[]>(accountsCount))
+    {
+        for (size_t i = 0; i < accountsCount; i++)
+        {
+            m_accounts[i].balance = initialBalance;
+        }
+    }
+
+    Money GetBalance(size_t index) const
+    {
+        std::shared_lock lock(m_accounts[index].mutex);
+        return m_accounts[index].balance;
+    }
+
+    bool TrySend(size_t src, size_t dst, Money amount)
+    {
+        if (src == dst)
+        {
+            return true;
+        }
+        std::scoped_lock lock(m_accounts[src].mutex, m_accounts[dst].mutex);
+        if (m_accounts[src].balance < amount)
+        {
+            return false;
+        }
+        m_accounts[src].balance -= amount;
+        m_accounts[dst].balance += amount;
+        return true;
+    }
+
+private:
+    // как и ячейки банка, каждый счет на своей кэш-линии
+    struct alignas(64) Account
+    {
+        mutable std::shared_mutex mutex;
+        Money balance = 0;
+    };
+
+    std::unique_ptr<Account[]> m_accounts;
+};
+
+struct Scenario
+{
+    std::string name;
+    // на горячих счетах читатели и писатели постоянно делят одни и те же строки кэша
+    int accountsCount;
+};
+
+struct BenchmarkConfig
+{
+    std::vector<Scenario> scenarios;
+    std::vector<int> threadCounts;
+    int operationsPerThread;
+};
+
+struct BenchmarkResult
+{
+    double readsPerSecond = 0;
+    double operationsPerSecond = 0;
+};
+
+// одна и та же последовательность операций для банка и для таблицы с shared_mutex
+struct Operation
+{
+    size_t src;
+    size_t dst;
+    bool isRead;
+};
+
+using Plans = std::vector<std::vector<Operation>>;
+
+std::vector<int> GetThreadCounts()
+{
+    int maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts;
+    for (int n = 1; n < maxThreads; n *= 2)
+    {
+        threadCounts.push_back(n);
+    }
+    threadCounts.push_back(maxThreads);
+    return threadCounts;
+}
+
+BenchmarkConfig GetConfig(bool isQuick)
+{
+    if (isQuick)
+    {
+        return {{{"hot", 8}, {"uniform", 10000}}, GetThreadCounts(), 200000};
+    }
+    return {{{"hot", 8}, {"warm", 256}, {"uniform", 100000}}, GetThreadCounts(), 2000000};
+}
+
+double Median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+// каждый поток выполняет свою заранее сгенерированную последовательность, чтобы генератор не попадал в замер
+Plans GeneratePlans(int accountsCount, int numThreads, int operationsPerThread, size_t& readsCount)
+{
+    Plans plans(numThreads);
+    readsCount = 0;
+    for (int t = 0; t < numThreads; t++)
+    {
+        std::mt19937 gen(t);
+        std::uniform_int_distribution<size_t> account(0, accountsCount - 1);
+        std::uniform_int_distribution<> percent(0, 99);
+        for (int i = 0; i < operationsPerThread; i++)
+        {
+            bool isRead = percent(gen) < READS_PER_HUNDRED;
+            plans[t].push_back({account(gen), account(gen), isRead});
+            readsCount += isRead;
+        }
+    }
+    return plans;
+}
+
+// read(index) возвращает баланс, send(src, dst) переводит единицу денег
+template<typename Read, typename Send>
+BenchmarkResult Measure(const Plans& plans, size_t readsCount, Read&& read, Send&& send)
+{
+    std::vector<double> times;
+    for (int repetition = 0; repetition < WARMUP_REPETITIONS + REPETITIONS; repetition++)
+    {
+        Timer timer;
+        {
+            std::vector<std::jthread> threads;
+            for (const auto& plan : plans)
+            {
+                threads.emplace_back([&read, &send, &plan] {
+                    Money checksum = 0;
+                    for (const auto& operation : plan)
+                    {
+                        if (operation.isRead)
+                        {
+                            checksum += read(operation.src);
+                        }
+                        else
+                        {
+                            send(operation.src, operation.dst);
+                        }
+                    }
+                    // не дает компилятору выбросить чтения
+                    if (checksum < 0)
+                    {
+                        std::cerr << "negative balance" << std::endl;
+                    }
+                });
+            }
+        }
+        double elapsed = timer.GetElapsed();
+        if (repetition >= WARMUP_REPETITIONS)
+        {
+            times.push_back(elapsed);
+        }
+    }
+
+    double median = Median(times);
+    double operations = static_cast<double>(plans.front().size()) * static_cast<double>(plans.size());
+    return {static_cast<double>(readsCount) / median, operations / median};
+}
+
+BenchmarkResult MeasureBank(const Scenario& scenario, const Plans& plans, size_t readsCount)
+{
+    Bank bank(static_cast<Money>(scenario.accountsCount) * INITIAL_BALANCE);
+    std::vector<AccountId> accounts;
+    for (int i = 0; i < scenario.accountsCount; i++)
+    {
+        accounts.push_back(bank.OpenAccount());
+        bank.DepositMoney(accounts.back(), INITIAL_BALANCE);
+    }
+
+    return Measure(plans, readsCount,
+            [&](size_t index) { return bank.GetAccountBalance(accounts[index]); },
+            [&](size_t src, size_t dst) { (void)bank.TrySendMoney(accounts[src], accounts[dst], 1); });
+}
+
+BenchmarkResult MeasureSharedMutex(const Scenario& scenario, const Plans& plans, size_t readsCount)
+{
+    SharedMutexAccounts table(scenario.accountsCount, INITIAL_BALANCE);
+    return Measure(plans, readsCount,
+            [&](size_t index) { return table.GetBalance(index); },
+            [&](size_t src, size_t dst) { (void)table.TrySend(src, dst, 1); });
+}
+
+int main(int argc, char* argv[])
+{
+    bool isQuick = argc > 1 && argv[1] == FLAG_QUICK;
+    BenchmarkConfig config = GetConfig(isQuick);
+
+    // speedup считается от однопоточного замера той же реализации, строки shared_mutex — базовая линия
+    std::cout << "engine,scenario,accounts,threads,reads_mops,total_mops,speedup,efficiency" << std::endl;
+    for (const auto& scenario : config.scenarios)
+    {
+        double baseReads[2] = {};
+        for (int numThreads : config.threadCounts)
+        {
+            size_t readsCount = 0;
+            Plans plans = GeneratePlans(scenario.accountsCount, numThreads, config.operationsPerThread, readsCount);
+            BenchmarkResult results[2] = {
+                    MeasureBank(scenario, plans, readsCount),
+                    MeasureSharedMutex(scenario, plans, readsCount),
+            };
+            const char* engines[2] = {"seqlock", "shared_mutex"};
+
+            for (int i = 0; i < 2; i++)
+            {
+                if (numThreads == config.threadCounts.front())
+                {
+                    baseReads[i] = results[i].readsPerSecond / numThreads;
+                }
+
+                double speedup = results[i].readsPerSecond / baseReads[i];
+                std::cout << engines[i] << ',' << scenario.name << ',' << scenario.accountsCount << ','
+                          << numThreads << ',' << std::fixed << std::setprecision(2)
+                          << results[i].readsPerSecond / 1e6 << ',' << results[i].operationsPerSecond / 1e6 << ','
+                          << speedup << ',' << speedup / numThreads << std::defaultfloat << std::endl;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,12 +1,24 @@
 #pragma once
 
 #include <iostream>
-#include <unordered_map>
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+#include <memory>
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <stdexcept>
-#include <shared_mutex>
+#include <string>
+#include <thread>
+#include "BankJournal.h"
+#include "SeqLock.h"
+#include "ShardedCounter.h"
 
+// младшие 32 бита — номер ячейки, старшие — поколение ячейки на момент открытия счета (всегда нечетное)
 using AccountId = unsigned long long;
 using Money = long long;
 
@@ -16,56 +28,119 @@ public:
     using std::runtime_error::runtime_error;
 };
 
+struct Transfer
+{
+    AccountId srcAccountId;
+    AccountId dstAccountId;
+    Money amount;
+};
+
+enum class TransferStatus
+{
+    Applied,
+    InsufficientFunds,
+    UnknownAccount,
+    InvalidAmount,
+    // сам перевод корректен, но пакет отклонен из-за ошибки в другом переводе
+    Aborted,
+};
+
+// согласованный срез: деньги на всех счетах на один и тот же момент между операциями
+struct BankSnapshot
+{
+    uint32_t epoch;
+    Money totalMoney;
+    size_t accountsCount;
+};
+
 class Bank
 {
 public:
-    struct Account
-    {
-        Money money{};
-        mutable std::shared_mutex mutex;
-    };
-
     explicit Bank(Money initialCash)
     {
         if (initialCash < 0)
         {
             throw std::out_of_range("Количество наличных в банке не может быть отрицательным");
         }
-        m_cash = initialCash;
+        m_cash.store(initialCash);
     };
 
+    // Банк с журналом в каталоге journalDirectory: состояние восстанавливается из снимка и журнала,
+    // операции возвращают управление только после того, как их записи сброшены на диск.
+    // Если журнал уже есть, деньги банка берутся из него, а не из initialCash
+    Bank(Money initialCash, const std::string& journalDirectory)
+            : Bank(initialCash)
+    {
+        m_journal = std::make_unique<BankJournal>(journalDirectory, initialCash);
+        Recover();
+        Checkpoint();
+        m_checkpointThread = std::jthread([this](std::stop_token stopToken) {
+            RunCheckpoints(stopToken);
+        });
+    }
+
     size_t GetAccountsCount() const
     {
-        std::shared_lock lock(m_mutexAccounts);
-        return m_accounts.size();
+        std::lock_guard lock(m_mutexAllocation);
+        return m_slotsCount - m_freeSlots.size();
     }
 
     AccountId OpenAccount()
     {
-        std::unique_lock lock(m_mutexAccounts);
-        m_accounts.emplace(std::piecewise_construct, std::forward_as_tuple(m_nextId), std::forward_as_tuple());
-        m_operationsCount++;
-        return m_nextId++;
+        AccountId accountId;
+        uint64_t lsn;
+        {
+            std::lock_guard allocationLock(m_mutexAllocation);
+            uint32_t index;
+            if (!m_freeSlots.empty())
+            {
+                index = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            }
+            else
+            {
+                index = AllocateSlot();
+            }
+
+            Slot& slot = GetSlot(index);
+            std::lock_guard lock(slot.seqLock);
+            accountId = MakeAccountId(index, slot.generation + 1);
+            try
+            {
+                lsn = Log({.operation = JournalOperation::Open, .epoch = m_epoch.load(), .srcAccountId = accountId});
+            }
+            catch (...)
+            {
+                m_freeSlots.push_back(index);
+                throw;
+            }
+            slot.generation++;
+        }
+        WaitDurable(lsn);
+        m_operationsCount.Increment();
+        return accountId;
     }
 
     Money CloseAccount(AccountId accountId)
     {
-        auto it = FindAccount(accountId);
-
         Money balance;
+        uint64_t lsn;
         {
-            std::unique_lock lock(it->second.mutex);
-            balance = it->second.money;
+            std::lock_guard allocationLock(m_mutexAllocation);
+            Slot& slot = FindSlot(accountId);
+            std::lock_guard lock(slot.seqLock);
+            CheckAccount(slot, accountId);
+            lsn = Log({.operation = JournalOperation::Close, .epoch = m_epoch.load(), .srcAccountId = accountId});
+            balance = slot.money;
+            slot.money.store(0, std::memory_order_relaxed);
+            // поколение становится четным: все выданные ранее идентификаторы ячейки недействительны
+            slot.generation++;
+            m_freeSlots.push_back(GetIndex(accountId));
         }
-        {
-            std::unique_lock lock(m_mutexAccounts);
-            m_accounts.erase(it);
-        }
-        {
-            std::unique_lock lock(m_mutexCash);
-            m_cash += balance;
-        }
-        m_operationsCount++;
+        // наличные возвращаются до ожидания диска: если запись не удастся, деньги банка все равно сойдутся
+        ReturnCash(balance);
+        WaitDurable(lsn);
+        m_operationsCount.Increment();
         return balance;
     }
 
@@ -80,18 +155,29 @@ public:
     bool TryDepositMoney(AccountId account, Money amount)
     {
         if (amount < 0) throw std::out_of_range("Количество денег не может быть отрицательным");
-        auto it = FindAccount(account);
-        {
-            std::unique_lock lock(m_mutexCash);
-            if (m_cash < amount) return false;
-            m_cash -= amount;
-        }
+        Slot& slot = FindSlot(account);
+        uint64_t lsn;
         {
-            std::unique_lock lock(it->second.mutex);
-            it->second.money += amount;
+            std::lock_guard lock(slot.seqLock);
+            CheckAccount(slot, account);
+            if (!TryTakeCash(amount)) return false;
+            uint32_t epoch = m_epoch.load();
+            try
+            {
+                lsn = Log({.operation = JournalOperation::Deposit, .epoch = epoch, .srcAccountId = account,
+                        .amount = amount});
+            }
+            catch (...)
+            {
+                ReturnCash(amount);
+                throw;
+            }
+            BeginWrite(slot, epoch);
+            AddMoney(slot, amount);
         }
+        WaitDurable(lsn);
 
-        m_operationsCount++;
+        m_operationsCount.Increment();
         return true;
     }
 
@@ -106,17 +192,21 @@ public:
     bool TryWithdrawMoney(AccountId account, Money amount)
     {
         if (amount < 0) throw std::out_of_range("Количество денег не может быть отрицательным");;
-        auto it = FindAccount(account);
-        {
-            std::unique_lock lock(it->second.mutex);
-            if (it->second.money < amount) return false;
-            it->second.money -= amount;
-        }
+        Slot& slot = FindSlot(account);
+        uint64_t lsn;
         {
-            std::unique_lock lock(m_mutexCash);
-            m_cash += amount;
+            std::lock_guard lock(slot.seqLock);
+            CheckAccount(slot, account);
+            if (slot.money < amount) return false;
+            uint32_t epoch = m_epoch.load();
+            lsn = Log({.operation = JournalOperation::Withdraw, .epoch = epoch, .srcAccountId = account,
+                    .amount = amount});
+            BeginWrite(slot, epoch);
+            AddMoney(slot, -amount);
         }
-        m_operationsCount++;
+        ReturnCash(amount);
+        WaitDurable(lsn);
+        m_operationsCount.Increment();
         return true;
     }
 
@@ -132,65 +222,465 @@ public:
     {
         if (amount < 0) throw std::out_of_range("Количество денег не может быть отрицательным");;
 
-        std::shared_lock lock(m_mutexAccounts);
-        auto srcIt = FindAccount(srcAccountId);
-        auto dstIt = FindAccount(dstAccountId);
-
+        Slot& src = FindSlot(srcAccountId);
+        Slot& dst = FindSlot(dstAccountId);
+        uint64_t lsn = 0;
+        if (&src == &dst)
         {
-            std::scoped_lock scopedLock(srcIt->second.mutex, dstIt->second.mutex);
-            if (srcIt->second.money < amount) return false;
-            srcIt->second.money -= amount;
-            dstIt->second.money += amount;
+            std::lock_guard lock(src.seqLock);
+            CheckAccount(src, srcAccountId);
+            CheckAccount(dst, dstAccountId);
+            if (src.money < amount) return false;
         }
+        else
+        {
+            std::scoped_lock scopedLock(src.seqLock, dst.seqLock);
+            CheckAccount(src, srcAccountId);
+            CheckAccount(dst, dstAccountId);
+            if (src.money < amount) return false;
+            uint32_t epoch = m_epoch.load();
+            lsn = Log({.operation = JournalOperation::Transfer, .epoch = epoch, .srcAccountId = srcAccountId,
+                    .dstAccountId = dstAccountId, .amount = amount});
+            BeginWrite(src, epoch);
+            BeginWrite(dst, epoch);
+            AddMoney(src, -amount);
+            AddMoney(dst, amount);
+        }
+        WaitDurable(lsn);
 
-        m_operationsCount++;
+        m_operationsCount.Increment();
         return true;
     }
 
-    Money GetTotalMoney() const
+    // переводы пакета применяются по порядку все или ни одного; каждый счет блокируется один раз,
+    // в порядке номеров ячеек, так что пакеты не взаимоблокируются ни друг с другом, ни с одиночными операциями
+    std::vector<TransferStatus> ApplyBatch(std::span<const Transfer> transfers)
     {
-        std::shared_lock lock(m_mutexAccounts);
-        Money total = 0;
-        for (const auto& [accountId, acc] : m_accounts)
+        std::vector<TransferStatus> statuses(transfers.size(), TransferStatus::Applied);
+
+        std::vector<uint32_t> indices;
+        indices.reserve(transfers.size() * 2);
+        for (size_t i = 0; i < transfers.size(); ++i)
         {
-            total += acc.money;
+            for (AccountId accountId : {transfers[i].srcAccountId, transfers[i].dstAccountId})
+            {
+                if (IsSlotAllocated(GetIndex(accountId)))
+                {
+                    indices.push_back(GetIndex(accountId));
+                }
+                else
+                {
+                    statuses[i] = TransferStatus::UnknownAccount;
+                }
+            }
         }
-        return total;
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+        std::vector<std::unique_lock<SeqLock>> locks;
+        locks.reserve(indices.size());
+        std::vector<Money> balances(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            Slot& slot = GetSlot(indices[i]);
+            locks.emplace_back(slot.seqLock);
+            balances[i] = slot.money;
+        }
+
+        // переводы применяются к копиям балансов, в ячейки они попадают, только если прошли все
+        auto findPosition = [&](AccountId accountId) {
+            return std::lower_bound(indices.begin(), indices.end(), GetIndex(accountId)) - indices.begin();
+        };
+        bool isFailed = false;
+        for (size_t i = 0; i < transfers.size(); ++i)
+        {
+            const Transfer& transfer = transfers[i];
+            if (statuses[i] == TransferStatus::UnknownAccount
+                || !IsAccountOpen(GetSlot(GetIndex(transfer.srcAccountId)), transfer.srcAccountId)
+                || !IsAccountOpen(GetSlot(GetIndex(transfer.dstAccountId)), transfer.dstAccountId))
+            {
+                statuses[i] = TransferStatus::UnknownAccount;
+                isFailed = true;
+                continue;
+            }
+            if (transfer.amount < 0)
+            {
+                statuses[i] = TransferStatus::InvalidAmount;
+                isFailed = true;
+                continue;
+            }
+
+            auto src = findPosition(transfer.srcAccountId);
+            auto dst = findPosition(transfer.dstAccountId);
+            if (balances[src] < transfer.amount)
+            {
+                statuses[i] = TransferStatus::InsufficientFunds;
+                isFailed = true;
+                continue;
+            }
+            balances[src] -= transfer.amount;
+            balances[dst] += transfer.amount;
+        }
+
+        if (isFailed)
+        {
+            std::replace(statuses.begin(), statuses.end(), TransferStatus::Applied, TransferStatus::Aborted);
+            return statuses;
+        }
+
+        uint32_t epoch = m_epoch.load();
+        uint64_t lsn = 0;
+        if (m_journal && !transfers.empty())
+        {
+            std::vector<JournalRecord> records;
+            records.reserve(transfers.size());
+            for (const auto& transfer : transfers)
+            {
+                records.push_back({.operation = JournalOperation::Transfer, .epoch = epoch,
+                        .groupSize = static_cast<uint32_t>(transfers.size()), .srcAccountId = transfer.srcAccountId,
+                        .dstAccountId = transfer.dstAccountId, .amount = transfer.amount});
+            }
+            lsn = m_journal->Append(records);
+        }
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            Slot& slot = GetSlot(indices[i]);
+            BeginWrite(slot, epoch);
+            slot.money.store(balances[i], std::memory_order_relaxed);
+        }
+        locks.clear();
+        WaitDurable(lsn);
+
+        m_operationsCount.Increment(transfers.size());
+        return statuses;
+    }
+
+    BankSnapshot TakeSnapshot() const
+    {
+        std::lock_guard allocationLock(m_mutexAllocation);
+        BankSnapshot snapshot{0, 0, 0};
+        // счет открыт, пока поколение его ячейки нечетное
+        snapshot.epoch = CaptureCut([&snapshot](uint32_t generation, Money money) {
+            snapshot.totalMoney += money;
+            snapshot.accountsCount += generation % 2;
+        });
+        return snapshot;
+    }
+
+    // записывает снимок таблицы счетов и удаляет ставшие ненужными сегменты журнала; без журнала ничего не делает
+    void Checkpoint()
+    {
+        if (!m_journal) return;
+        std::lock_guard checkpointLock(m_mutexCheckpoint);
+        uint64_t firstSegment = m_journal->Rotate();
+        BankJournal::Snapshot snapshot;
+        {
+            std::lock_guard allocationLock(m_mutexAllocation);
+            snapshot.slots.reserve(m_slotsCount);
+            snapshot.epoch = CaptureCut([&snapshot](uint32_t generation, Money money) {
+                snapshot.slots.push_back({generation, money});
+            });
+        }
+        m_journal->WriteSnapshot(snapshot, firstSegment);
     }
 
+    Money GetTotalMoney() const
+    {
+        return TakeSnapshot().totalMoney;
+    }
+
+    // без блокировки: читатель ничего не пишет в ячейку и повторяет чтение, только если ее изменили
     Money GetAccountBalance(AccountId accountId) const
     {
-        auto it = FindAccount(accountId);
-        std::shared_lock lock(it->second.mutex);
-        return it->second.money;
+        const Slot& slot = FindSlot(accountId);
+        while (true)
+        {
+            uint32_t version = slot.seqLock.ReadBegin();
+            bool isOpen = IsAccountOpen(slot, accountId);
+            Money money = slot.money.load(std::memory_order_relaxed);
+            if (slot.seqLock.ReadRetry(version)) continue;
+
+            if (!isOpen)
+            {
+                throw BankOperationError("Неизвестный аккаунт");
+            }
+            return money;
+        }
+    }
+
+    Money GetCash() const
+    {
+        return m_cash.load(std::memory_order_relaxed);
     }
 
     unsigned long long GetOperationsCount() const
     {
-        return m_operationsCount;
+        return m_operationsCount.Get();
     }
 
 private:
-    mutable std::shared_mutex m_mutexCash;
-    mutable std::shared_mutex m_mutexAccounts;// accountsMutex
-    AccountId m_nextId = 0;
-    std::unordered_map<AccountId, Account> m_accounts;
-    std::atomic<unsigned long long> m_operationsCount = 0;
-    Money m_cash;
+    // ровно строка кэша: соседние счета не делят строку и не мешают друг другу;
+    // поколение нечетное, пока счет открыт, и четное, пока ячейка свободна
+    struct alignas(64) Slot
+    {
+        mutable SeqLock seqLock;
+        // читаются и без блокировки, поэтому атомарные; пишутся только под seqLock
+        std::atomic<Money> money = 0;
+        // баланс на момент среза epoch, если ячейку меняли после него
+        Money stableMoney = 0;
+        std::atomic<uint32_t> generation = 0;
+        uint32_t epoch = 0;
+    };
+
+    // ячейки выделяются блоками и никогда не перемещаются, поэтому поиск идет без блокировок:
+    // каталог блоков только дополняется, указатель на блок публикуется после его создания
+    static const constexpr size_t CHUNK_BITS = 12;
+    static const constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static const constexpr size_t MAX_CHUNKS = size_t(1) << 12;
+    static const constexpr AccountId INDEX_MASK = 0xFFFFFFFFull;
+
+    mutable std::mutex m_mutexAllocation;
+    std::vector<std::unique_ptr<Slot[]>> m_chunks;
+    std::array<std::atomic<Slot*>, MAX_CHUNKS> m_directory{};
+    uint32_t m_slotsCount = 0;
+    std::vector<uint32_t> m_freeSlots;
+    ShardedCounter m_operationsCount;
+    mutable std::atomic<uint32_t> m_epoch = 0;
+    // отдельная строка кэша: касса меняется на каждом депозите и снятии
+    alignas(64) std::atomic<Money> m_cash;
+
+    static const constexpr std::chrono::seconds CHECKPOINT_INTERVAL{10};
+    std::unique_ptr<BankJournal> m_journal;
+    std::mutex m_mutexCheckpoint;
+    // последним: останавливается раньше, чем разрушаются счета и журнал
+    std::jthread m_checkpointThread;
+
+    static AccountId MakeAccountId(uint32_t index, uint32_t generation)
+    {
+        return (static_cast<AccountId>(generation) << 32) | index;
+    }
 
-    std::unordered_map<AccountId, Account>::iterator FindAccount(AccountId accountId)
+    static uint32_t GetIndex(AccountId accountId)
     {
-        std::shared_lock lock(m_mutexAccounts);
-        auto it = m_accounts.find(accountId);
-        if (it == m_accounts.end()) throw BankOperationError("Неизвестный аккаунт");
-        return it;
+        return static_cast<uint32_t>(accountId & INDEX_MASK);
+    }
+
+    static uint32_t GetGeneration(AccountId accountId)
+    {
+        return static_cast<uint32_t>(accountId >> 32);
+    }
+
+    // вызывается под m_mutexAllocation
+    uint32_t AllocateSlot()
+    {
+        if (m_slotsCount % CHUNK_SIZE == 0)
+        {
+            if (m_chunks.size() == MAX_CHUNKS)
+            {
+                throw BankOperationError("Превышено максимальное количество счетов");
+            }
+            m_chunks.push_back(std::make_unique<Slot[]>(CHUNK_SIZE));
+            m_directory[m_chunks.size() - 1].store(m_chunks.back().get(), std::memory_order_release);
+        }
+        return m_slotsCount++;
+    }
+
+    Slot& GetSlot(uint32_t index) const
+    {
+        Slot* chunk = m_directory[index >> CHUNK_BITS].load(std::memory_order_acquire);
+        return chunk[index & (CHUNK_SIZE - 1)];
+    }
+
+    bool IsSlotAllocated(uint32_t index) const
+    {
+        return (index >> CHUNK_BITS) < MAX_CHUNKS
+               && m_directory[index >> CHUNK_BITS].load(std::memory_order_acquire) != nullptr;
+    }
+
+    // ячейка по идентификатору; открыт ли счет, проверяется уже под блокировкой ячейки
+    Slot& FindSlot(AccountId accountId) const
+    {
+        if (!IsSlotAllocated(GetIndex(accountId)))
+        {
+            throw BankOperationError("Неизвестный аккаунт");
+        }
+        return GetSlot(GetIndex(accountId));
+    }
+
+    static bool IsAccountOpen(const Slot& slot, AccountId accountId)
+    {
+        return GetGeneration(accountId) % 2 == 1 && slot.generation == GetGeneration(accountId);
+    }
+
+    // вызывается под блокировкой ячейки перед изменением баланса; все ячейки одной операции помечаются
+    // одной прочитанной эпохой, поэтому срез видит операцию либо целиком, либо не видит совсем
+    static void BeginWrite(Slot& slot, uint32_t epoch)
+    {
+        if (slot.epoch != epoch)
+        {
+            slot.stableMoney = slot.money;
+            slot.epoch = epoch;
+        }
+    }
+
+    // Вызывается под m_mutexAllocation. Переводы, депозиты и снятия не останавливаются: момент среза —
+    // увеличение эпохи, а ячейку, которую меняют после него, писатель сначала помечает новой эпохой
+    // и сохраняет ее баланс на момент среза. visit получает поколение и баланс каждой ячейки по порядку
+    template<typename Visitor>
+    uint32_t CaptureCut(Visitor&& visit) const
+    {
+        uint32_t epoch = ++m_epoch;
+        for (uint32_t index = 0; index < m_slotsCount; ++index)
+        {
+            const Slot& slot = GetSlot(index);
+            std::lock_guard lock(slot.seqLock);
+            visit(slot.generation.load(std::memory_order_relaxed),
+                    slot.epoch == epoch ? slot.stableMoney : slot.money.load(std::memory_order_relaxed));
+        }
+        return epoch;
+    }
+
+    // вызывается под блокировками всех ячеек операции до их изменения: если журнал отказал, исключение
+    // вылетит раньше, чем операция что-то поменяет; 0 — ждать нечего
+    uint64_t Log(const JournalRecord& record)
+    {
+        return m_journal ? m_journal->Append({&record, 1}) : 0;
+    }
+
+    // вызывается уже без блокировок, чтобы за время ожидания диска другие потоки успели дописать свои записи.
+    // Исключение отсюда значит, что операция применена в памяти, но на диск не попала
+    void WaitDurable(uint64_t lsn)
+    {
+        if (m_journal && lsn != 0)
+        {
+            m_journal->WaitDurable(lsn);
+        }
+    }
+
+    // вызывается из конструктора, пока банком больше никто не пользуется
+    void Recover()
+    {
+        uint32_t lastEpoch = 0;
+        m_journal->Recover(
+                [this, &lastEpoch](const BankJournal::Snapshot& snapshot) {
+                    lastEpoch = snapshot.epoch;
+                    for (const auto& image : snapshot.slots)
+                    {
+                        Slot& slot = GetSlot(AllocateSlot());
+                        slot.generation = image.generation;
+                        slot.money = image.money;
+                    }
+                },
+                [this, &lastEpoch](std::span<const JournalRecord> group) {
+                    lastEpoch = std::max(lastEpoch, group.front().epoch);
+                    for (const auto& record : group)
+                    {
+                        ReplayRecord(record);
+                    }
+                });
+        m_epoch = lastEpoch;
+
+        Money total = 0;
+        for (uint32_t index = 0; index < m_slotsCount; ++index)
+        {
+            const Slot& slot = GetSlot(index);
+            total += slot.money;
+            if (slot.generation % 2 == 0)
+            {
+                m_freeSlots.push_back(index);
+            }
+        }
+        if (total > m_journal->GetInitialCash())
+        {
+            throw BankOperationError("Журнал поврежден: на счетах больше денег, чем есть у банка");
+        }
+        m_cash = m_journal->GetInitialCash() - total;
+    }
+
+    void ReplayRecord(const JournalRecord& record)
+    {
+        uint32_t index = GetIndex(record.srcAccountId);
+        while (m_slotsCount <= index)
+        {
+            AllocateSlot();
+        }
+        Slot& src = GetSlot(index);
+        switch (record.operation)
+        {
+            case JournalOperation::Open:
+                src.generation = GetGeneration(record.srcAccountId);
+                src.money = 0;
+                break;
+            case JournalOperation::Close:
+                src.generation = GetGeneration(record.srcAccountId) + 1;
+                src.money = 0;
+                break;
+            case JournalOperation::Deposit:
+                AddMoney(src, record.amount);
+                break;
+            case JournalOperation::Withdraw:
+                AddMoney(src, -record.amount);
+                break;
+            case JournalOperation::Transfer:
+                AddMoney(src, -record.amount);
+                AddMoney(FindSlot(record.dstAccountId), record.amount);
+                break;
+            default:
+                throw BankOperationError("Журнал поврежден: неизвестная операция");
+        }
+    }
+
+    void RunCheckpoints(std::stop_token stopToken)
+    {
+        std::mutex mutex;
+        std::condition_variable_any stopped;
+        std::unique_lock lock(mutex);
+        while (!stopped.wait_for(lock, stopToken, CHECKPOINT_INTERVAL, [] { return false; })
+               && !stopToken.stop_requested())
+        {
+            try
+            {
+                Checkpoint();
+            }
+            catch (const std::exception& e)
+            {
+                // журнал продолжает расти, следующая попытка — через интервал
+                std::cerr << "Не удалось записать снимок банка: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    // вызывается под блокировкой ячейки: порядок записей обеспечивает seqLock, поэтому хватает relaxed
+    static void AddMoney(Slot& slot, Money amount)
+    {
+        slot.money.store(slot.money.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static void CheckAccount(const Slot& slot, AccountId accountId)
+    {
+        if (!IsAccountOpen(slot, accountId))
+        {
+            throw BankOperationError("Неизвестный аккаунт");
+        }
+    }
+
+    // касса — независимый счетчик, деньги на счетах защищены своими блокировками,
+    // поэтому упорядочивать с ними ее изменения не нужно и хватает relaxed
+    bool TryTakeCash(Money amount)
+    {
+        Money current = m_cash.load(std::memory_order_relaxed);
+        do
+        {
+            if (current < amount) return false;
+        }
+        while (!m_cash.compare_exchange_weak(current, current - amount,
+                std::memory_order_relaxed,
+                std::memory_order_relaxed));
+        return true;
     }
 
-    std::unordered_map<AccountId, Account>::const_iterator FindAccount(AccountId accountId) const
+    void ReturnCash(Money amount)
     {
-        std::shared_lock lock(m_mutexAccounts);
-        auto it = m_accounts.find(accountId);
-        if (it == m_accounts.end()) throw BankOperationError("Неизвестный аккаунт");
-        return it;
+        m_cash.fetch_add(amount, std::memory_order_relaxed);
     }
 };
\ No newline at end of file
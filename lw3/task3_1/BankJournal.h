@@ -0,0 +1,571 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "_libs/_helpers.h"
+
+enum class JournalOperation : uint8_t
+{
+    Open = 1,
+    Close,
+    Deposit,
+    Withdraw,
+    Transfer,
+};
+
+// логическая запись об успешной операции; при восстановлении применяется без проверок
+struct JournalRecord
+{
+    JournalOperation operation;
+    // эпоха, прочитанная операцией под блокировками ее счетов
+    uint32_t epoch = 0;
+    // сколько записей подряд составляют одну операцию: пакет переводов восстанавливается только целиком
+    uint32_t groupSize = 1;
+    uint64_t srcAccountId = 0;
+    uint64_t dstAccountId = 0;
+    int64_t amount = 0;
+};
+
+// Журнал упреждающей записи: сегменты segment-<номер>.wal с записями операций и снимок таблицы счетов.
+// Записи копятся в памяти; поток, которому нужна надежность, становится лидером и одним fdatasync
+// сбрасывает на диск и свои записи, и все, что успели дописать остальные, пока он ждал диск
+class BankJournal
+{
+public:
+    struct SlotImage
+    {
+        uint32_t generation;
+        int64_t money;
+    };
+
+    struct Snapshot
+    {
+        uint32_t epoch = 0;
+        std::vector<SlotImage> slots;
+    };
+
+    using GroupHandler = std::function<void(std::span<const JournalRecord>)>;
+
+    BankJournal(const std::string& directory, int64_t initialCash)
+            : m_directory(directory),
+              m_initialCash(initialCash)
+    {
+        std::filesystem::create_directories(m_directory);
+    }
+
+    BankJournal(const BankJournal&) = delete;
+    BankJournal& operator=(const BankJournal&) = delete;
+
+    ~BankJournal()
+    {
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+    }
+
+    // деньги банка, записанные в журнал при его создании; у восстановленного журнала они важнее переданных
+    [[nodiscard]] int64_t GetInitialCash() const
+    {
+        return m_initialCash;
+    }
+
+    // Вызывается один раз до начала работы: отдает снимок и группы записей, которых в нем нет, в порядке журнала.
+    // Оборванная при сбое последняя группа отрезается, новые записи идут в новый сегмент
+    void Recover(const std::function<void(const Snapshot&)>& onSnapshot, const GroupHandler& onGroup)
+    {
+        std::optional<Snapshot> snapshot = ReadSnapshot();
+        if (snapshot)
+        {
+            onSnapshot(*snapshot);
+        }
+
+        std::vector<uint64_t> segments = ListSegments();
+        for (size_t i = 0; i < segments.size(); ++i)
+        {
+            int64_t initialCash = ReplaySegment(segments[i], i + 1 == segments.size(),
+                    snapshot ? snapshot->epoch : 0, onGroup);
+            if (!snapshot && i == 0)
+            {
+                m_initialCash = initialCash;
+            }
+        }
+
+        m_segment = segments.empty() ? 0 : segments.back() + 1;
+        m_fd = OpenSegment(m_segment);
+    }
+
+    // вызывается под блокировками всех счетов операции до их изменения, поэтому по каждому счету порядок записей
+    // совпадает с порядком изменений; возвращает номер, которого надо дождаться в WaitDurable.
+    // После ошибки записи бросает исключение, и операция не применяется
+    uint64_t Append(std::span<const JournalRecord> records)
+    {
+        std::lock_guard lock(m_mutex);
+        CheckFailure();
+        size_t offset = m_buffer.size();
+        m_buffer.resize(offset + records.size() * RECORD_SIZE);
+        for (const auto& record : records)
+        {
+            EncodeRecord(record, m_buffer.data() + offset);
+            offset += RECORD_SIZE;
+        }
+        return ++m_lastLsn;
+    }
+
+    void WaitDurable(uint64_t lsn)
+    {
+        std::unique_lock lock(m_mutex);
+        while (m_durableLsn < lsn)
+        {
+            CheckFailure();
+            if (m_isFlushing)
+            {
+                m_flushed.wait(lock);
+                continue;
+            }
+
+            m_isFlushing = true;
+            std::swap(m_buffer, m_flushBuffer);
+            uint64_t targetLsn = m_lastLsn;
+            lock.unlock();
+            try
+            {
+                WriteAll(m_fd, m_flushBuffer);
+                CheckFunctionCall(fdatasync, m_fd);
+            }
+            catch (...)
+            {
+                lock.lock();
+                m_isFlushing = false;
+                m_isFailed = true;
+                m_flushed.notify_all();
+                throw;
+            }
+            m_flushBuffer.clear();
+
+            lock.lock();
+            m_isFlushing = false;
+            m_durableLsn = targetLsn;
+            m_flushed.notify_all();
+        }
+    }
+
+    // сбрасывает все принятые записи в текущий сегмент и начинает новый; возвращает номер нового сегмента.
+    // Вызывается до увеличения эпохи среза: записи с эпохой снимка и новее попадают только в новые сегменты.
+    // Как и лидер в WaitDurable, диск ждет без мьютекса: записи, добавленные за это время, уйдут в новый сегмент
+    uint64_t Rotate()
+    {
+        std::unique_lock lock(m_mutex);
+        m_flushed.wait(lock, [this] { return !m_isFlushing; });
+        CheckFailure();
+
+        m_isFlushing = true;
+        std::swap(m_buffer, m_flushBuffer);
+        uint64_t targetLsn = m_lastLsn;
+        uint64_t segment = m_segment + 1;
+        lock.unlock();
+        int fd;
+        try
+        {
+            WriteAll(m_fd, m_flushBuffer);
+            CheckFunctionCall(fdatasync, m_fd);
+            fd = OpenSegment(segment);
+        }
+        catch (...)
+        {
+            lock.lock();
+            m_isFlushing = false;
+            m_isFailed = true;
+            m_flushed.notify_all();
+            throw;
+        }
+        m_flushBuffer.clear();
+        close(m_fd);
+
+        lock.lock();
+        m_fd = fd;
+        m_segment = segment;
+        m_isFlushing = false;
+        m_durableLsn = targetLsn;
+        m_flushed.notify_all();
+        return segment;
+    }
+
+    // снимок пишется во временный файл и атомарно подменяет прежний; после этого сегменты
+    // до firstSegment больше не нужны для восстановления. Ошибка записи, как и в WaitDurable, отключает журнал
+    void WriteSnapshot(const Snapshot& snapshot, uint64_t firstSegment)
+    {
+        try
+        {
+            WriteSnapshotFile(snapshot);
+        }
+        catch (...)
+        {
+            std::lock_guard lock(m_mutex);
+            m_isFailed = true;
+            m_flushed.notify_all();
+            throw;
+        }
+
+        for (uint64_t segment : ListSegments())
+        {
+            if (segment < firstSegment)
+            {
+                std::filesystem::remove(GetSegmentPath(segment));
+            }
+        }
+    }
+
+private:
+    static const constexpr uint64_t SEGMENT_MAGIC = 0x314C41574B4E4142ull;
+    static const constexpr uint64_t SNAPSHOT_MAGIC = 0x31504E534B4E4142ull;
+    static const constexpr std::string_view SEGMENT_PREFIX = "segment-";
+    static const constexpr size_t SEGMENT_HEADER_SIZE = 2 * sizeof(uint64_t);
+    // операция, эпоха, размер группы, два счета и сумма; за ними контрольная сумма
+    static const constexpr size_t RECORD_PAYLOAD_SIZE = 1 + 4 + 4 + 8 + 8 + 8;
+    static const constexpr size_t RECORD_SIZE = RECORD_PAYLOAD_SIZE + 8;
+
+    std::filesystem::path m_directory;
+    int64_t m_initialCash;
+    uint64_t m_segment = 0;
+    int m_fd = -1;
+
+    std::mutex m_mutex;
+    std::condition_variable m_flushed;
+    std::vector<char> m_buffer;
+    // буфер, который сейчас пишет лидер; остальные в это время дописывают в m_buffer
+    std::vector<char> m_flushBuffer;
+    uint64_t m_lastLsn = 0;
+    uint64_t m_durableLsn = 0;
+    bool m_isFlushing = false;
+    bool m_isFailed = false;
+
+    template<typename T>
+    static void PutValue(std::vector<char>& data, T value)
+    {
+        size_t offset = data.size();
+        data.resize(offset + sizeof(T));
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+
+    template<typename T>
+    static T GetValue(const char*& data)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return value;
+    }
+
+    // FNV-1a: ловит оборванные и недописанные записи, от намеренной порчи не защищает
+    static uint64_t CalculateChecksum(const char* data, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static void EncodeRecord(const JournalRecord& record, char* out)
+    {
+        char* position = out;
+        auto put = [&position](auto value) {
+            std::memcpy(position, &value, sizeof(value));
+            position += sizeof(value);
+        };
+        put(static_cast<uint8_t>(record.operation));
+        put(record.epoch);
+        put(record.groupSize);
+        put(record.srcAccountId);
+        put(record.dstAccountId);
+        put(record.amount);
+        put(CalculateChecksum(out, RECORD_PAYLOAD_SIZE));
+    }
+
+    static std::optional<JournalRecord> DecodeRecord(const char* data)
+    {
+        const char* position = data;
+        JournalRecord record{};
+        record.operation = static_cast<JournalOperation>(GetValue<uint8_t>(position));
+        record.epoch = GetValue<uint32_t>(position);
+        record.groupSize = GetValue<uint32_t>(position);
+        record.srcAccountId = GetValue<uint64_t>(position);
+        record.dstAccountId = GetValue<uint64_t>(position);
+        record.amount = GetValue<int64_t>(position);
+        if (GetValue<uint64_t>(position) != CalculateChecksum(data, RECORD_PAYLOAD_SIZE) || record.groupSize == 0)
+        {
+            return std::nullopt;
+        }
+        return record;
+    }
+
+    static void WriteAll(int fd, const std::vector<char>& data)
+    {
+        size_t written = 0;
+        while (written < data.size())
+        {
+            ssize_t count = write(fd, data.data() + written, data.size() - written);
+            if (count < 0)
+            {
+                // прерванная сигналом запись ничего не записала, ее можно просто повторить
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::runtime_error(std::string("Не удалось записать журнал: ") + std::strerror(errno));
+            }
+            written += count;
+        }
+    }
+
+    // fsync файла или каталога по пути
+    static void SyncPath(const std::filesystem::path& path, int flags)
+    {
+        int fd = CheckFunctionCall(open, path.c_str(), flags | O_CLOEXEC);
+        try
+        {
+            CheckFunctionCall(fsync, fd);
+        }
+        catch (...)
+        {
+            close(fd);
+            throw;
+        }
+        close(fd);
+    }
+
+    static std::vector<char> ReadFile(const std::filesystem::path& path)
+    {
+        std::vector<char> data(std::filesystem::file_size(path));
+        int fd = CheckFunctionCall(open, path.c_str(), O_RDONLY | O_CLOEXEC);
+        size_t offset = 0;
+        while (offset < data.size())
+        {
+            ssize_t count = read(fd, data.data() + offset, data.size() - offset);
+            if (count <= 0)
+            {
+                close(fd);
+                throw std::runtime_error("Не удалось прочитать файл журнала: " + path.string());
+            }
+            offset += count;
+        }
+        close(fd);
+        return data;
+    }
+
+    void CheckFailure() const
+    {
+        if (m_isFailed)
+        {
+            throw std::runtime_error("Журнал недоступен после ошибки записи");
+        }
+    }
+
+    [[nodiscard]] std::string GetSnapshotPath() const
+    {
+        return (m_directory / "snapshot.bin").string();
+    }
+
+    [[nodiscard]] std::filesystem::path GetSegmentPath(uint64_t segment) const
+    {
+        // номер дополнен нулями, чтобы сегменты и в листинге каталога шли по порядку
+        char number[32];
+        std::snprintf(number, sizeof(number), "%020llu", static_cast<unsigned long long>(segment));
+        return m_directory / (std::string(SEGMENT_PREFIX) + number + ".wal");
+    }
+
+    [[nodiscard]] std::vector<uint64_t> ListSegments() const
+    {
+        std::vector<uint64_t> segments;
+        for (const auto& entry : std::filesystem::directory_iterator(m_directory))
+        {
+            std::string stem = entry.path().stem().string();
+            if (entry.path().extension() == ".wal" && stem.starts_with(SEGMENT_PREFIX))
+            {
+                segments.push_back(std::stoull(stem.substr(SEGMENT_PREFIX.size())));
+            }
+        }
+        std::sort(segments.begin(), segments.end());
+        return segments;
+    }
+
+    // созданный или переименованный файл переживет сбой, только если сброшен и сам каталог
+    void SyncDirectory() const
+    {
+        SyncPath(m_directory, O_RDONLY | O_DIRECTORY);
+    }
+
+    // создает сегмент с заголовком и возвращает его дескриптор
+    int OpenSegment(uint64_t segment) const
+    {
+        std::vector<char> header;
+        PutValue(header, SEGMENT_MAGIC);
+        PutValue(header, m_initialCash);
+
+        int fd = CheckFunctionCall(open, GetSegmentPath(segment).c_str(),
+                O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+        try
+        {
+            WriteAll(fd, header);
+            CheckFunctionCall(fdatasync, fd);
+            SyncDirectory();
+        }
+        catch (...)
+        {
+            close(fd);
+            throw;
+        }
+        return fd;
+    }
+
+    void WriteSnapshotFile(const Snapshot& snapshot) const
+    {
+        std::vector<char> data;
+        PutValue(data, SNAPSHOT_MAGIC);
+        PutValue(data, m_initialCash);
+        PutValue(data, snapshot.epoch);
+        PutValue(data, static_cast<uint32_t>(snapshot.slots.size()));
+        for (const auto& slot : snapshot.slots)
+        {
+            PutValue(data, slot.generation);
+            PutValue(data, slot.money);
+        }
+        PutValue(data, CalculateChecksum(data.data(), data.size()));
+
+        std::string tempPath = GetSnapshotPath() + ".tmp";
+        int fd = CheckFunctionCall(open, tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        try
+        {
+            WriteAll(fd, data);
+            CheckFunctionCall(fsync, fd);
+        }
+        catch (...)
+        {
+            close(fd);
+            throw;
+        }
+        close(fd);
+        CheckFunctionCall(rename, tempPath.c_str(), GetSnapshotPath().c_str());
+        SyncDirectory();
+    }
+
+    std::optional<Snapshot> ReadSnapshot()
+    {
+        if (!std::filesystem::exists(GetSnapshotPath()))
+        {
+            return std::nullopt;
+        }
+
+        std::vector<char> data = ReadFile(GetSnapshotPath());
+        const size_t headerSize = 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t);
+        const size_t slotSize = sizeof(uint32_t) + sizeof(int64_t);
+        const char* position = data.data();
+        auto fail = [this] {
+            return std::runtime_error("Снимок журнала поврежден: " + GetSnapshotPath());
+        };
+        if (data.size() < headerSize + sizeof(uint64_t) || GetValue<uint64_t>(position) != SNAPSHOT_MAGIC)
+        {
+            throw fail();
+        }
+
+        m_initialCash = GetValue<int64_t>(position);
+        Snapshot snapshot;
+        snapshot.epoch = GetValue<uint32_t>(position);
+        auto slotsCount = GetValue<uint32_t>(position);
+        if (data.size() != headerSize + slotsCount * slotSize + sizeof(uint64_t))
+        {
+            throw fail();
+        }
+        snapshot.slots.resize(slotsCount);
+        for (auto& slot : snapshot.slots)
+        {
+            slot.generation = GetValue<uint32_t>(position);
+            slot.money = GetValue<int64_t>(position);
+        }
+        if (GetValue<uint64_t>(position) != CalculateChecksum(data.data(), data.size() - sizeof(uint64_t)))
+        {
+            throw fail();
+        }
+        return snapshot;
+    }
+
+    // записи с эпохой меньше эпохи снимка уже учтены в нем и пропускаются; возвращает деньги банка из заголовка
+    int64_t ReplaySegment(uint64_t segment, bool isLast, uint32_t snapshotEpoch, const GroupHandler& onGroup)
+    {
+        std::filesystem::path path = GetSegmentPath(segment);
+        std::vector<char> data = ReadFile(path);
+        const char* header = data.data();
+        if (data.size() < SEGMENT_HEADER_SIZE || GetValue<uint64_t>(header) != SEGMENT_MAGIC)
+        {
+            if (!isLast)
+            {
+                throw std::runtime_error("Сегмент журнала поврежден: " + path.string());
+            }
+            // сбой случился сразу после создания сегмента, записей в нем нет
+            std::filesystem::remove(path);
+            SyncDirectory();
+            return m_initialCash;
+        }
+        auto initialCash = GetValue<int64_t>(header);
+
+        size_t offset = SEGMENT_HEADER_SIZE;
+        std::vector<JournalRecord> group;
+        while (offset < data.size())
+        {
+            group.clear();
+            size_t groupOffset = offset;
+            bool isComplete = true;
+            do
+            {
+                std::optional<JournalRecord> record;
+                if (offset + RECORD_SIZE <= data.size())
+                {
+                    record = DecodeRecord(data.data() + offset);
+                }
+                if (!record || (!group.empty() && record->groupSize != group.front().groupSize))
+                {
+                    isComplete = false;
+                    break;
+                }
+                group.push_back(*record);
+                offset += RECORD_SIZE;
+            }
+            while (group.size() < group.front().groupSize);
+
+            if (!isComplete)
+            {
+                if (!isLast)
+                {
+                    throw std::runtime_error("Сегмент журнала поврежден: " + path.string());
+                }
+                // операции оборванной группы не были подтверждены, их просто не было. Обрезка сбрасывается на диск:
+                // вернись хвост после нового сбоя, сегмент был бы уже не последним, и восстановление сочло бы его поврежденным
+                CheckFunctionCall(truncate, path.c_str(), static_cast<off_t>(groupOffset));
+                SyncPath(path, O_WRONLY);
+                return initialCash;
+            }
+            if (group.front().epoch >= snapshotEpoch)
+            {
+                onGroup(group);
+            }
+        }
+        return initialCash;
+    }
+};
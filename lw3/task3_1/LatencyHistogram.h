@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+// Гистограмма задержек в наносекундах с относительной ошибкой не больше 1 / SUB_BUCKETS:
+// значения разбиты по степеням двойки, а каждая степень — на SUB_BUCKETS равных частей.
+// Размер не зависит от числа замеров, поэтому у каждого потока своя, а в конце они складываются
+class LatencyHistogram
+{
+public:
+    void Record(uint64_t nanoseconds)
+    {
+        m_counts[GetIndex(nanoseconds)]++;
+        m_count++;
+        m_max = std::max(m_max, nanoseconds);
+    }
+
+    void Merge(const LatencyHistogram& other)
+    {
+        for (size_t i = 0; i < m_counts.size(); ++i)
+        {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_count += other.m_count;
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    [[nodiscard]] uint64_t GetCount() const
+    {
+        return m_count;
+    }
+
+    [[nodiscard]] uint64_t GetMax() const
+    {
+        return m_max;
+    }
+
+    // верхняя граница корзины, в которую попал замер с номером percentile * count
+    [[nodiscard]] uint64_t GetPercentile(double percentile) const
+    {
+        auto target = static_cast<uint64_t>(std::ceil(percentile * static_cast<double>(m_count)));
+        uint64_t accumulated = 0;
+        for (size_t i = 0; i < m_counts.size(); ++i)
+        {
+            accumulated += m_counts[i];
+            if (accumulated >= std::max<uint64_t>(target, 1))
+            {
+                return std::min(GetUpperValue(i), m_max);
+            }
+        }
+        return m_max;
+    }
+
+private:
+    static const constexpr int SUB_BUCKET_BITS = 5;
+    static const constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // значения меньше SUB_BUCKETS хранятся точно, дальше по группе корзин на каждую степень двойки
+    static const constexpr size_t BUCKETS_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    std::array<uint64_t, BUCKETS_COUNT> m_counts{};
+    uint64_t m_count = 0;
+    uint64_t m_max = 0;
+
+    static size_t GetIndex(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+        {
+            return value;
+        }
+        int exponent = std::bit_width(value) - 1;
+        uint64_t subBucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+        return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket;
+    }
+
+    static uint64_t GetUpperValue(size_t index)
+    {
+        if (index < SUB_BUCKETS)
+        {
+            return index;
+        }
+        int exponent = static_cast<int>(index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+        uint64_t width = uint64_t(1) << (exponent - SUB_BUCKET_BITS);
+        return (uint64_t(1) << exponent) + (index % SUB_BUCKETS) * width + width - 1;
+    }
+};
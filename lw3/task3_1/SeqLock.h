@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// Блокировка с номером версии: писатели захватывают ее как мьютекс (lock/unlock, подходит для
+// std::lock_guard и std::scoped_lock), а читатели ничего не пишут — запоминают четную версию,
+// читают данные и перечитывают, если версия за это время изменилась.
+// Данные, которые читаются без блокировки, должны быть атомарными (хватает relaxed).
+// Запись короткая, поэтому ожидающий сначала крутится с yield и только после SPIN_COUNT попыток засыпает
+// в atomic::wait: так длинная запись или вытесненный писатель не занимают ядра ожидающими.
+// Цена — notify_all в каждом unlock, но без спящих он обходится проверкой счетчика ожидающих
+class SeqLock
+{
+public:
+    static const constexpr int SPIN_COUNT = 64;
+
+    void lock()
+    {
+        uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+        for (int attempt = 1;
+             sequence % 2 == 1
+             || !m_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire,
+                                                  std::memory_order_relaxed);
+             ++attempt)
+        {
+            Wait(sequence, attempt);
+            sequence = m_sequence.load(std::memory_order_relaxed);
+        }
+        // записи данных не должны стать видны раньше нечетной версии
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    bool try_lock()
+    {
+        uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+        if (sequence % 2 == 1
+            || !m_sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire,
+                                                   std::memory_order_relaxed))
+        {
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return true;
+    }
+
+    void unlock()
+    {
+        m_sequence.fetch_add(1, std::memory_order_release);
+        m_sequence.notify_all();
+    }
+
+    // пока писатель держит блокировку, ждем
+    [[nodiscard]] uint32_t ReadBegin() const
+    {
+        uint32_t sequence = m_sequence.load(std::memory_order_acquire);
+        for (int attempt = 1; sequence % 2 == 1; ++attempt)
+        {
+            Wait(sequence, attempt);
+            sequence = m_sequence.load(std::memory_order_acquire);
+        }
+        return sequence;
+    }
+
+    // true, если прочитанное могло быть разорвано записью и чтение надо повторить
+    [[nodiscard]] bool ReadRetry(uint32_t sequence) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_sequence.load(std::memory_order_relaxed) != sequence;
+    }
+
+private:
+    std::atomic<uint32_t> m_sequence = 0;
+
+    void Wait(uint32_t sequence, int attempt) const
+    {
+        // при четной версии CAS проиграл другому писателю: блокировка свободна, засыпать не на чем
+        if (attempt < SPIN_COUNT || sequence % 2 == 0)
+        {
+            std::this_thread::yield();
+            return;
+        }
+        m_sequence.wait(sequence, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Счетчик из ячеек в разных строках кэша: поток увеличивает свою ячейку, чтение складывает все.
+// Сумма точна, когда увеличения не идут, а под нагрузкой — значение на какой-то момент чтения
+class ShardedCounter
+{
+public:
+    void Increment(unsigned long long delta = 1)
+    {
+        m_shards[GetShardIndex()].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] unsigned long long Get() const
+    {
+        unsigned long long total = 0;
+        for (const auto& shard : m_shards)
+        {
+            total += shard.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    static const constexpr size_t SHARDS_COUNT = 64;
+
+    struct alignas(64) Shard
+    {
+        std::atomic<unsigned long long> value = 0;
+    };
+
+    std::array<Shard, SHARDS_COUNT> m_shards;
+
+    // потоки получают ячейки по кругу при первом обращении
+    static size_t GetShardIndex()
+    {
+        static std::atomic<size_t> nextIndex = 0;
+        thread_local size_t index = nextIndex.fetch_add(1, std::memory_order_relaxed) % SHARDS_COUNT;
+        return index;
+    }
+};
@@ -137,8 +137,7 @@ private:
         auto bart = std::make_shared<Bart>(bartId, *apu);
         auto liza = std::make_shared<Liza>(lizaId, *apu);
         auto marge = std::make_shared<Marge>(margeId, apuId, *m_bank);
-        auto homer = std::make_shared<Homer>(homerId, margeId, bernsId, *m_
-        bank, *bart, *liza);
+        auto homer = std::make_shared<Homer>(homerId, margeId, bernsId, *m_bank, *bart, *liza);
 
         m_actors = {homer, marge, bart, liza, apu, berns};
 
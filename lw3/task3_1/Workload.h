@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "Bank.h"
+#include "LatencyHistogram.h"
+
+enum class ArrivalMode
+{
+    // следующая операция сразу после предыдущей: меряется предельная пропускная способность
+    Closed,
+    // операции через равные промежутки
+    Fixed,
+    // пуассоновский поток: промежутки распределены экспоненциально, бывают всплески
+    Poisson,
+};
+
+struct WorkloadConfig
+{
+    size_t accountsCount = 1000;
+    int threadsCount = 4;
+    double durationSeconds = 10;
+    // доли операций в процентах, в сумме 100
+    int transferPercent = 80;
+    int depositPercent = 10;
+    int withdrawPercent = 10;
+    // показатель Зипфа: 0 — все счета равновероятны, около 1 — несколько счетов получают большую часть операций
+    double zipfSkew = 0;
+    ArrivalMode arrivalMode = ArrivalMode::Closed;
+    // операций в секунду на все потоки вместе, для Fixed и Poisson
+    double targetRate = 0;
+};
+
+struct WorkloadReport
+{
+    unsigned long long completedCount = 0;
+    // операции, которые банк отклонил: не хватило денег на счете или в кассе
+    unsigned long long rejectedCount = 0;
+    // операции, завершившиеся исключением, например после ошибки записи журнала
+    unsigned long long failedCount = 0;
+    double elapsedSeconds = 0;
+    // задержки от запланированного момента начала операции до ее завершения, включая отклоненные и сбойные
+    LatencyHistogram latency;
+};
+
+// номер от 0 до n - 1 с вероятностью, пропорциональной 1 / (номер + 1)^skew; накопленные вероятности
+// считаются один раз, выбор — двоичный поиск по ним
+class ZipfDistribution
+{
+public:
+    ZipfDistribution(size_t n, double skew)
+            : m_cdf(n)
+    {
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), skew);
+            m_cdf[i] = sum;
+        }
+        for (double& value : m_cdf)
+        {
+            value /= sum;
+        }
+    }
+
+    template<typename Generator>
+    size_t operator()(Generator& gen) const
+    {
+        double value = std::uniform_real_distribution<>(0.0, 1.0)(gen);
+        auto index = static_cast<size_t>(std::upper_bound(m_cdf.begin(), m_cdf.end(), value) - m_cdf.begin());
+        return std::min(index, m_cdf.size() - 1);
+    }
+
+private:
+    std::vector<double> m_cdf;
+};
+
+// Синтетическая нагрузка на банк: threadsCount потоков выполняют случайные переводы, депозиты и снятия
+// над accountsCount счетами. Задержка считается от запланированного момента, а не от фактического начала,
+// иначе отставший от расписания поток скрыл бы очередь, которую видел бы клиент
+class Workload
+{
+public:
+    static const constexpr Money INITIAL_BALANCE = 1000;
+    static const constexpr Money MAX_AMOUNT = 100;
+
+    Workload(Bank& bank, const WorkloadConfig& config)
+            : m_bank(bank),
+              m_config(config),
+              m_zipf(config.accountsCount, config.zipfSkew)
+    {
+        if (config.accountsCount == 0 || config.threadsCount <= 0 || config.durationSeconds <= 0)
+        {
+            throw std::invalid_argument("accounts, threads and duration must be positive");
+        }
+        if (config.transferPercent < 0 || config.depositPercent < 0 || config.withdrawPercent < 0
+            || config.transferPercent + config.depositPercent + config.withdrawPercent != 100)
+        {
+            throw std::invalid_argument("operation mix must be non-negative and sum up to 100");
+        }
+        if (config.arrivalMode != ArrivalMode::Closed && config.targetRate <= 0)
+        {
+            throw std::invalid_argument("arrival rate must be positive");
+        }
+    }
+
+    // открывает счета, кладет на каждый до INITIAL_BALANCE из наличных банка и после прогона закрывает их,
+    // так что повторный запуск на том же журнале начинает с теми же деньгами в кассе
+    WorkloadReport Run()
+    {
+        OpenAccounts();
+
+        std::vector<WorkloadReport> reports(m_config.threadsCount);
+        auto start = Clock::now() + std::chrono::milliseconds(START_DELAY_MS);
+        auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(m_config.durationSeconds));
+        {
+            std::vector<std::jthread> threads;
+            for (int i = 0; i < m_config.threadsCount; ++i)
+            {
+                threads.emplace_back([this, i, start, deadline, &reports] {
+                    RunWorker(i, start, deadline, reports[i]);
+                });
+            }
+        }
+
+        WorkloadReport report;
+        report.elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        for (const auto& workerReport : reports)
+        {
+            report.completedCount += workerReport.completedCount;
+            report.rejectedCount += workerReport.rejectedCount;
+            report.failedCount += workerReport.failedCount;
+            report.latency.Merge(workerReport.latency);
+        }
+
+        try
+        {
+            CloseAccounts();
+        }
+        catch (const std::exception&)
+        {
+            // журнал отказал во время прогона: счета останутся открытыми, но отчет все равно нужен
+            report.failedCount++;
+        }
+        return report;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    // потоки стартуют одновременно, когда все уже созданы
+    static const constexpr int START_DELAY_MS = 50;
+    static const constexpr std::chrono::microseconds SPIN_INTERVAL{200};
+
+    Bank& m_bank;
+    WorkloadConfig m_config;
+    ZipfDistribution m_zipf;
+    // перемешаны, чтобы популярные номера не оказались соседними ячейками банка
+    std::vector<AccountId> m_accounts;
+
+    // банк, восстановленный из журнала, мог сохранить счета прерванного прогона вместе с их деньгами,
+    // поэтому вклад делится из того, что осталось в кассе
+    void OpenAccounts()
+    {
+        Money balance = std::min(INITIAL_BALANCE, m_bank.GetCash() / static_cast<Money>(m_config.accountsCount));
+        if (balance == 0)
+        {
+            throw std::runtime_error("bank has no cash left to fund the workload accounts");
+        }
+
+        m_accounts.clear();
+        m_accounts.reserve(m_config.accountsCount);
+        for (size_t i = 0; i < m_config.accountsCount; ++i)
+        {
+            m_accounts.push_back(m_bank.OpenAccount());
+            m_bank.DepositMoney(m_accounts.back(), balance);
+        }
+        std::shuffle(m_accounts.begin(), m_accounts.end(), std::mt19937_64(42));
+    }
+
+    void CloseAccounts()
+    {
+        for (AccountId account : m_accounts)
+        {
+            m_bank.CloseAccount(account);
+        }
+        m_accounts.clear();
+    }
+
+    void RunWorker(int index, Clock::time_point start, Clock::time_point deadline, WorkloadReport& report)
+    {
+        std::mt19937_64 gen(index + 1);
+        WorkloadReport local;
+
+        // каждый поток держит свою долю общей частоты, расписания потоков сдвинуты друг относительно друга
+        double meanInterval = m_config.targetRate > 0 ? m_config.threadsCount / m_config.targetRate : 0;
+        std::exponential_distribution<> poissonInterval(meanInterval > 0 ? 1 / meanInterval : 1);
+        auto toDuration = [](double seconds) {
+            return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+        };
+        Clock::time_point intended = start + toDuration(meanInterval * index / m_config.threadsCount);
+        std::this_thread::sleep_until(start);
+
+        while (true)
+        {
+            if (m_config.arrivalMode == ArrivalMode::Closed)
+            {
+                intended = Clock::now();
+            }
+            if (intended >= deadline) break;
+            if (m_config.arrivalMode != ArrivalMode::Closed)
+            {
+                WaitUntil(intended);
+            }
+
+            // исключение не должно выйти из jthread и завершить программу: клиент увидел бы ошибку, поток идет дальше
+            try
+            {
+                if (ExecuteOperation(gen))
+                {
+                    local.completedCount++;
+                }
+                else
+                {
+                    local.rejectedCount++;
+                }
+            }
+            catch (const std::exception&)
+            {
+                local.failedCount++;
+            }
+            local.latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - intended).count());
+
+            if (m_config.arrivalMode == ArrivalMode::Fixed)
+            {
+                intended += toDuration(meanInterval);
+            }
+            else if (m_config.arrivalMode == ArrivalMode::Poisson)
+            {
+                intended += toDuration(poissonInterval(gen));
+            }
+        }
+        report = local;
+    }
+
+    // sleep_until просыпается с опозданием в десятки микросекунд, и оно попало бы в задержку операции,
+    // поэтому последний отрезок ожидания поток проводит в yield
+    static void WaitUntil(Clock::time_point moment)
+    {
+        std::this_thread::sleep_until(moment - SPIN_INTERVAL);
+        while (Clock::now() < moment)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    template<typename Generator>
+    bool ExecuteOperation(Generator& gen)
+    {
+        int percent = std::uniform_int_distribution<>(0, 99)(gen);
+        Money amount = std::uniform_int_distribution<Money>(1, MAX_AMOUNT)(gen);
+        AccountId account = m_accounts[m_zipf(gen)];
+
+        if (percent < m_config.transferPercent)
+        {
+            return m_bank.TrySendMoney(account, m_accounts[m_zipf(gen)], amount);
+        }
+        if (percent < m_config.transferPercent + m_config.depositPercent)
+        {
+            return m_bank.TryDepositMoney(account, amount);
+        }
+        return m_bank.TryWithdrawMoney(account, amount);
+    }
+};
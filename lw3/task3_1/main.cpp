@@ -1,24 +1,39 @@
 #include <iostream>
+#include <iomanip>
+#include <sstream>
 #include <vector>
 #include "_libs/_helpers.h"
 #include "_libs/_exceptionHandler.h"
 #include "SimulationController.h"
+#include "Workload.h"
 
 const std::string FLAG_PARALLEL = "-P";
 const std::string FLAG_SEQUENTIAL = "-S";
 const std::string FLAG_TEST_MOD = "--test";
 const std::string FLAG_LOGGING_ON = "-L";
 const std::string FLAG_DURATION_ON = "-D";
+const std::string FLAG_JOURNAL = "-J";
+const std::string FLAG_WORKLOAD = "-W";
+const std::string FLAG_MIX = "-M";
+const std::string FLAG_ZIPF = "-Z";
+const std::string FLAG_FIXED_RATE = "-R";
+const std::string FLAG_POISSON_RATE = "-O";
 const Money BANK_BALANCE = 100000;
 
 void PrintUsage()
 {
     Logger::Println("Usage:");
-    Logger::Println(
-            "\tbank " + FLAG_PARALLEL + " <money in circulation> <simulation duration> <optional: -L> <optional: -D>");
-    Logger::Println("\tbank " + FLAG_SEQUENTIAL +
-                    " <money in circulation> <simulation duration> <optional: -L> <optional: -D>");
-    Logger::Println("\tbank " + FLAG_SEQUENTIAL + " <money in circulation> --test <optional: -L> <optional: -D>");
+    Logger::Println("\tbank " + FLAG_PARALLEL
+                    + " <money in circulation> <simulation duration> <optional: -L> <optional: -D> <optional: -J dir>");
+    Logger::Println("\tbank " + FLAG_SEQUENTIAL
+                    + " <money in circulation> <simulation duration> <optional: -L> <optional: -D> <optional: -J dir>");
+    Logger::Println("\tbank " + FLAG_SEQUENTIAL
+                    + " <money in circulation> --test <optional: -L> <optional: -D> <optional: -J dir>");
+    Logger::Println("\tbank " + FLAG_WORKLOAD + " <accounts> <threads> <duration> <optional: -M transfer:deposit:withdraw>"
+                    + " <optional: -Z zipf skew> <optional: -R ops/sec | -O ops/sec> <optional: -J dir>");
+    Logger::Println("\t-J dir: keep the bank in a write-ahead journal in dir and restore it from there on start");
+    Logger::Println("\t-M: operation mix in percent, 80:10:10 by default");
+    Logger::Println("\t-R, -O: fixed or Poisson arrival rate for all threads; without them threads run back to back");
 }
 
 struct ProgramArgs
@@ -29,11 +44,72 @@ struct ProgramArgs
     bool isDurationOn = false;
     Money initialCash = 0;
     double durationLimit = 0;
+    std::string journalDirectory;
+    bool isWorkload = false;
+    WorkloadConfig workload;
 };
 
+ProgramArgs ParseWorkloadArgs(int argc, char* argv[])
+{
+    if (argc < 5 || argc > 13)
+    {
+        PrintUsage();
+        throw std::invalid_argument("invalid count of arguments");
+    }
+
+    ProgramArgs args;
+    args.isWorkload = true;
+    args.workload.accountsCount = std::stoull(argv[2]);
+    args.workload.threadsCount = std::stoi(argv[3]);
+    args.workload.durationSeconds = std::stod(argv[4]);
+
+    for (int i = 5; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        if (i + 1 == argc)
+        {
+            PrintUsage();
+            throw std::invalid_argument("option <" + option + "> requires a value");
+        }
+        std::string value = argv[++i];
+
+        if (EqualsIgnoreCase(option, FLAG_MIX))
+        {
+            char separator1, separator2;
+            std::istringstream mix(value);
+            mix >> args.workload.transferPercent >> separator1 >> args.workload.depositPercent >> separator2
+                >> args.workload.withdrawPercent;
+            if (!mix || separator1 != ':' || separator2 != ':')
+            {
+                throw std::invalid_argument("invalid operation mix <" + value + ">");
+            }
+        }
+        else if (EqualsIgnoreCase(option, FLAG_ZIPF)) args.workload.zipfSkew = std::stod(value);
+        else if (EqualsIgnoreCase(option, FLAG_FIXED_RATE) || EqualsIgnoreCase(option, FLAG_POISSON_RATE))
+        {
+            args.workload.arrivalMode = EqualsIgnoreCase(option, FLAG_FIXED_RATE)
+                                        ? ArrivalMode::Fixed
+                                        : ArrivalMode::Poisson;
+            args.workload.targetRate = std::stod(value);
+        }
+        else if (EqualsIgnoreCase(option, FLAG_JOURNAL)) args.journalDirectory = value;
+        else
+        {
+            PrintUsage();
+            throw std::invalid_argument("invalid option <" + option + ">");
+        }
+    }
+
+    return args;
+}
+
 ProgramArgs ParseArgs(int argc, char* argv[])
 {
-    if (argc < 4 || argc > 6)
+    if (argc > 1 && EqualsIgnoreCase(argv[1], FLAG_WORKLOAD))
+    {
+        return ParseWorkloadArgs(argc, argv);
+    }
+    if (argc < 4 || argc > 8)
     {
         PrintUsage();
         throw std::invalid_argument("invalid count of arguments");
@@ -54,12 +130,59 @@ ProgramArgs ParseArgs(int argc, char* argv[])
     if (EqualsIgnoreCase(argv[3], FLAG_TEST_MOD)) args.isTestMod = true;
     else args.durationLimit = std::stod(argv[3]);
 
-    if (argc >= 5 && EqualsIgnoreCase(argv[4], FLAG_LOGGING_ON)) args.isLoggingOn = true;
-    if (argc == 6 && EqualsIgnoreCase(argv[5], FLAG_DURATION_ON)) args.isDurationOn = true;
+    for (int i = 4; i < argc; ++i)
+    {
+        if (EqualsIgnoreCase(argv[i], FLAG_LOGGING_ON)) args.isLoggingOn = true;
+        else if (EqualsIgnoreCase(argv[i], FLAG_DURATION_ON)) args.isDurationOn = true;
+        else if (EqualsIgnoreCase(argv[i], FLAG_JOURNAL) && i + 1 < argc) args.journalDirectory = argv[++i];
+        else
+        {
+            PrintUsage();
+            throw std::invalid_argument("invalid option <" + std::string(argv[i]) + ">");
+        }
+    }
 
     return args;
 }
 
+void PrintWorkloadReport(const WorkloadConfig& config, const WorkloadReport& report)
+{
+    auto microseconds = [](uint64_t nanoseconds) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1) << static_cast<double>(nanoseconds) / 1000 << " us";
+        return out.str();
+    };
+    unsigned long long total = report.completedCount + report.rejectedCount + report.failedCount;
+
+    std::ostringstream throughput;
+    throughput << std::fixed << std::setprecision(0) << static_cast<double>(total) / report.elapsedSeconds;
+    if (config.arrivalMode != ArrivalMode::Closed)
+    {
+        throughput << " (target " << config.targetRate << ")";
+    }
+
+    Logger::Println("operations: " + std::to_string(total) + ", rejected: " + std::to_string(report.rejectedCount)
+                    + ", failed: " + std::to_string(report.failedCount));
+    Logger::Println("ops/sec: " + throughput.str());
+    Logger::Println("latency p50: " + microseconds(report.latency.GetPercentile(0.5))
+                    + ", p90: " + microseconds(report.latency.GetPercentile(0.9))
+                    + ", p99: " + microseconds(report.latency.GetPercentile(0.99))
+                    + ", p99.9: " + microseconds(report.latency.GetPercentile(0.999))
+                    + ", max: " + microseconds(report.latency.GetMax()));
+}
+
+void RunWorkload(const ProgramArgs& args)
+{
+    // половина денег лежит на счетах, половина остается в кассе для депозитов
+    Money bankBalance = static_cast<Money>(args.workload.accountsCount) * Workload::INITIAL_BALANCE * 2;
+    auto bank = args.journalDirectory.empty()
+                ? std::make_shared<Bank>(bankBalance)
+                : std::make_shared<Bank>(bankBalance, args.journalDirectory);
+
+    Workload workload(*bank, args.workload);
+    PrintWorkloadReport(args.workload, workload.Run());
+}
+
 std::atomic<SimulationController*> activeController = nullptr;
 
 void GlobalSignalHandler(int signal)
@@ -78,8 +201,15 @@ int main(int argc, char* argv[])
     ExceptionHandler exceptionHandler;
     exceptionHandler.Handle([&]() {
         ProgramArgs args = ParseArgs(argc, argv);
+        if (args.isWorkload)
+        {
+            RunWorkload(args);
+            return;
+        }
 
-        auto bank = std::make_shared<Bank>(BANK_BALANCE);
+        auto bank = args.journalDirectory.empty()
+                    ? std::make_shared<Bank>(BANK_BALANCE)
+                    : std::make_shared<Bank>(BANK_BALANCE, args.journalDirectory);
         auto sim = std::make_shared<Simulation>(bank, args.initialCash,
                 args.durationLimit, args.isLoggingOn, args.isDurationOn);
         SimulationController simulationController(sim, args.isTestMod, args.isParallel);
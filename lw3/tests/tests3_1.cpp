@@ -0,0 +1,450 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <csignal>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include "../task3_1/Bank.h"
+#include "../task3_1/Workload.h"
+
+namespace
+{
+std::vector<AccountId> OpenAccounts(Bank& bank, int count, Money balance)
+{
+    std::vector<AccountId> accounts;
+    for (int i = 0; i < count; ++i)
+    {
+        accounts.push_back(bank.OpenAccount());
+        bank.DepositMoney(accounts.back(), balance);
+    }
+    return accounts;
+}
+
+// пустой каталог журнала, удаляется после теста
+class JournalDirectory
+{
+public:
+    explicit JournalDirectory(const std::string& name)
+            : m_path(std::filesystem::temp_directory_path() / ("bank-tests-" + name))
+    {
+        std::filesystem::remove_all(m_path);
+    }
+
+    ~JournalDirectory()
+    {
+        std::filesystem::remove_all(m_path);
+    }
+
+    [[nodiscard]] std::string GetPath() const
+    {
+        return m_path.string();
+    }
+
+    [[nodiscard]] std::vector<std::filesystem::path> ListSegments() const
+    {
+        std::vector<std::filesystem::path> segments;
+        for (const auto& entry : std::filesystem::directory_iterator(m_path))
+        {
+            if (entry.path().extension() == ".wal")
+            {
+                segments.push_back(entry.path());
+            }
+        }
+        std::sort(segments.begin(), segments.end());
+        return segments;
+    }
+
+private:
+    std::filesystem::path m_path;
+};
+}
+
+TEST(BankBatchTest, AppliesWholeBatch)
+{
+    Bank bank(300);
+    auto accounts = OpenAccounts(bank, 3, 100);
+
+    std::vector<Transfer> batch{{accounts[0], accounts[1], 60}, {accounts[1], accounts[2], 150}};
+    auto statuses = bank.ApplyBatch(batch);
+
+    EXPECT_EQ(statuses, std::vector<TransferStatus>(2, TransferStatus::Applied));
+    EXPECT_EQ(bank.GetAccountBalance(accounts[0]), 40);
+    EXPECT_EQ(bank.GetAccountBalance(accounts[1]), 10);
+    EXPECT_EQ(bank.GetAccountBalance(accounts[2]), 250);
+}
+
+TEST(BankBatchTest, InsufficientFundsLeavesEverythingUnchanged)
+{
+    Bank bank(1000);
+    auto accounts = OpenAccounts(bank, 4, 100);
+
+    std::vector<Transfer> batch{
+            {accounts[0], accounts[1], 50},
+            {accounts[2], accounts[3], 30},
+            {accounts[3], accounts[0], 500},
+            {accounts[1], accounts[2], 10},
+    };
+    auto statuses = bank.ApplyBatch(batch);
+
+    EXPECT_EQ(statuses, (std::vector<TransferStatus>{TransferStatus::Aborted, TransferStatus::Aborted,
+                                                     TransferStatus::InsufficientFunds, TransferStatus::Aborted}));
+    for (AccountId account : accounts)
+    {
+        EXPECT_EQ(bank.GetAccountBalance(account), 100);
+    }
+    EXPECT_EQ(bank.GetTotalMoney(), 400);
+    EXPECT_EQ(bank.GetCash(), 600);
+}
+
+TEST(BankBatchTest, UnknownAccountAbortsBatch)
+{
+    Bank bank(200);
+    auto accounts = OpenAccounts(bank, 2, 100);
+    AccountId closed = bank.OpenAccount();
+    bank.CloseAccount(closed);
+
+    std::vector<Transfer> batch{{accounts[0], accounts[1], 10}, {accounts[1], closed, 10}};
+    auto statuses = bank.ApplyBatch(batch);
+
+    EXPECT_EQ(statuses[0], TransferStatus::Aborted);
+    EXPECT_EQ(statuses[1], TransferStatus::UnknownAccount);
+    EXPECT_EQ(bank.GetAccountBalance(accounts[0]), 100);
+    EXPECT_EQ(bank.GetAccountBalance(accounts[1]), 100);
+}
+
+// Каждый пакет — цикл переводов одной суммы, поэтому ни один баланс не меняется, если пакет применяется целиком.
+// Потоки обходят счета в противоположных порядках, и счета пакетов пересекаются: блокировки берутся
+// по номерам ячеек, иначе такие пакеты взаимоблокировались бы. Читатели проверяют, что промежуточное
+// состояние пакета никогда не видно
+TEST(BankBatchTest, OverlappingBatchesInOppositeOrder)
+{
+    const int accountsCount = 6;
+    const int batchesPerThread = 20000;
+    const Money balance = 100;
+    Bank bank(accountsCount * balance);
+    auto accounts = OpenAccounts(bank, accountsCount, balance);
+
+    std::atomic<bool> isRunning = true;
+    std::atomic<int> wrongReads = 0;
+    std::atomic<int> appliedCount = 0;
+    std::vector<std::jthread> readers;
+    for (int i = 0; i < 2; ++i)
+    {
+        readers.emplace_back([&] {
+            while (isRunning)
+            {
+                for (AccountId account : accounts)
+                {
+                    wrongReads += bank.GetAccountBalance(account) != balance;
+                }
+            }
+        });
+    }
+
+    {
+        std::vector<std::jthread> writers;
+        for (int direction : {1, -1})
+        {
+            writers.emplace_back([&, direction] {
+                for (int i = 0; i < batchesPerThread; ++i)
+                {
+                    // цикл из трех счетов, сдвинутый на i; второй поток проходит его в обратную сторону
+                    std::vector<AccountId> cycle;
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        cycle.push_back(accounts[(i + direction * k + accountsCount) % accountsCount]);
+                    }
+                    // сумма больше баланса иногда делает пакет неприменимым целиком
+                    Money amount = i % 10 == 0 ? balance + 1 : 1 + i % balance;
+                    std::vector<Transfer> batch{
+                            {cycle[0], cycle[1], amount},
+                            {cycle[1], cycle[2], amount},
+                            {cycle[2], cycle[0], amount},
+                    };
+                    auto statuses = bank.ApplyBatch(batch);
+                    appliedCount += statuses.front() == TransferStatus::Applied;
+                }
+            });
+        }
+    }
+    isRunning = false;
+    readers.clear();
+
+    EXPECT_EQ(wrongReads, 0);
+    EXPECT_EQ(appliedCount, 2 * batchesPerThread * 9 / 10);
+    for (AccountId account : accounts)
+    {
+        EXPECT_EQ(bank.GetAccountBalance(account), balance);
+    }
+    EXPECT_EQ(bank.GetTotalMoney(), accountsCount * balance);
+}
+
+TEST(BankSnapshotTest, CountsOnlyOpenAccounts)
+{
+    Bank bank(0);
+    std::vector<AccountId> accounts;
+    for (int i = 0; i < 10; ++i)
+    {
+        accounts.push_back(bank.OpenAccount());
+    }
+    for (int i = 0; i < 5; ++i)
+    {
+        bank.CloseAccount(accounts[i]);
+    }
+    // новые счета занимают освобожденные ячейки, их поколение снова нечетное
+    bank.OpenAccount();
+    bank.OpenAccount();
+
+    EXPECT_EQ(bank.TakeSnapshot().accountsCount, 7);
+    EXPECT_EQ(bank.GetAccountsCount(), 7);
+    for (int i = 0; i < 5; ++i)
+    {
+        EXPECT_THROW(bank.GetAccountBalance(accounts[i]), std::exception);
+    }
+}
+
+// Переводы идут между постоянными счетами, а другие потоки открывают счета, переводят на них деньги,
+// возвращают их и закрывают счета. Наличные при этом не меняются, поэтому каждый срез вместе с наличными
+// должен давать все деньги банка, а число открытых счетов — лежать между постоянными и постоянными плюс
+// по одному на каждый такой поток
+TEST(BankSnapshotTest, ConsistentUnderConcurrentTransfersAndChurn)
+{
+    const int accountsCount = 8;
+    const int churnersCount = 2;
+    const Money balance = 1000;
+    const Money initialCash = accountsCount * balance + 500;
+    Bank bank(initialCash);
+    auto accounts = OpenAccounts(bank, accountsCount, balance);
+
+    std::atomic<bool> isRunning = true;
+    std::vector<std::jthread> threads;
+    for (int t = 0; t < 2; ++t)
+    {
+        threads.emplace_back([&, t] {
+            for (int i = 0; isRunning; ++i)
+            {
+                bank.TrySendMoney(accounts[(i + t) % accountsCount], accounts[(i * 3 + 1) % accountsCount], 1 + i % 50);
+            }
+        });
+    }
+    for (int t = 0; t < churnersCount; ++t)
+    {
+        threads.emplace_back([&, t] {
+            for (int i = 0; isRunning; ++i)
+            {
+                AccountId source = accounts[(i + t) % accountsCount];
+                AccountId temporary = bank.OpenAccount();
+                if (bank.TrySendMoney(source, temporary, 10))
+                {
+                    bank.SendMoney(temporary, source, 10);
+                }
+                bank.CloseAccount(temporary);
+            }
+        });
+    }
+
+    int wrongTotals = 0;
+    int wrongCounts = 0;
+    for (int i = 0; i < 20000; ++i)
+    {
+        BankSnapshot snapshot = bank.TakeSnapshot();
+        wrongTotals += snapshot.totalMoney + bank.GetCash() != initialCash;
+        wrongCounts += snapshot.accountsCount < accountsCount || snapshot.accountsCount > accountsCount + churnersCount;
+    }
+    isRunning = false;
+    threads.clear();
+
+    EXPECT_EQ(wrongTotals, 0);
+    EXPECT_EQ(wrongCounts, 0);
+    EXPECT_EQ(bank.TakeSnapshot().accountsCount, accountsCount);
+    EXPECT_EQ(bank.GetTotalMoney() + bank.GetCash(), initialCash);
+}
+
+TEST(BankJournalTest, TornLastGroupIsTruncated)
+{
+    JournalDirectory directory("torn");
+    std::filesystem::path segment;
+    {
+        BankJournal journal(directory.GetPath(), 1000);
+        journal.Recover([](const BankJournal::Snapshot&) {}, [](std::span<const JournalRecord>) {});
+        journal.Append(std::vector<JournalRecord>{{.operation = JournalOperation::Open, .srcAccountId = 1}});
+        std::vector<JournalRecord> batch(2, {.operation = JournalOperation::Transfer, .groupSize = 2, .amount = 5});
+        journal.WaitDurable(journal.Append(batch));
+        segment = directory.ListSegments().back();
+    }
+    // сбой посреди записи пакета: от второй записи группы на диске осталась только часть
+    auto fullSize = std::filesystem::file_size(segment);
+    std::filesystem::resize_file(segment, fullSize - 10);
+
+    std::vector<size_t> groups;
+    BankJournal journal(directory.GetPath(), 0);
+    journal.Recover([](const BankJournal::Snapshot&) {}, [&groups](std::span<const JournalRecord> group) {
+        groups.push_back(group.size());
+    });
+
+    EXPECT_EQ(groups, std::vector<size_t>{1});
+    EXPECT_EQ(journal.GetInitialCash(), 1000);
+    // отрезана вся оборванная группа, а не только ее недописанная запись: остались заголовок и первая запись
+    const uintmax_t headerSize = 16;
+    uintmax_t recordSize = (fullSize - headerSize) / 3;
+    EXPECT_EQ(std::filesystem::file_size(segment), headerSize + recordSize);
+}
+
+TEST(BankJournalTest, TornBatchIsNotRecovered)
+{
+    JournalDirectory directory("torn-batch");
+    AccountId first;
+    AccountId second;
+    {
+        Bank bank(1000, directory.GetPath());
+        first = bank.OpenAccount();
+        second = bank.OpenAccount();
+        bank.DepositMoney(first, 300);
+        std::vector<Transfer> batch{{first, second, 100}, {first, second, 50}};
+        bank.ApplyBatch(batch);
+    }
+    auto segment = directory.ListSegments().back();
+    std::filesystem::resize_file(segment, std::filesystem::file_size(segment) - 1);
+
+    Bank bank(1000, directory.GetPath());
+    EXPECT_EQ(bank.GetAccountBalance(first), 300);
+    EXPECT_EQ(bank.GetAccountBalance(second), 0);
+    EXPECT_EQ(bank.GetCash(), 700);
+}
+
+TEST(BankJournalTest, ReplaysSegmentsAfterSnapshot)
+{
+    JournalDirectory directory("snapshot");
+    std::vector<AccountId> accounts;
+    std::vector<Money> balances;
+    Money cash;
+    {
+        Bank bank(10000, directory.GetPath());
+        accounts = OpenAccounts(bank, 4, 1000);
+        bank.SendMoney(accounts[0], accounts[1], 300);
+        bank.Checkpoint();
+
+        // эти операции есть только в сегментах после снимка
+        bank.SendMoney(accounts[1], accounts[2], 700);
+        bank.WithdrawMoney(accounts[3], 400);
+        bank.CloseAccount(accounts[0]);
+        accounts.push_back(bank.OpenAccount());
+        bank.DepositMoney(accounts.back(), 50);
+        std::vector<Transfer> batch{{accounts[2], accounts[4], 100}, {accounts[1], accounts[3], 200}};
+        bank.ApplyBatch(batch);
+
+        for (size_t i = 1; i < accounts.size(); ++i)
+        {
+            balances.push_back(bank.GetAccountBalance(accounts[i]));
+        }
+        cash = bank.GetCash();
+    }
+    ASSERT_TRUE(std::filesystem::exists(std::filesystem::path(directory.GetPath()) / "snapshot.bin"));
+
+    // деньги банка берутся из журнала, а не из переданного значения
+    Bank bank(0, directory.GetPath());
+    EXPECT_THROW(bank.GetAccountBalance(accounts[0]), std::exception);
+    for (size_t i = 1; i < accounts.size(); ++i)
+    {
+        EXPECT_EQ(bank.GetAccountBalance(accounts[i]), balances[i - 1]);
+    }
+    EXPECT_EQ(bank.GetCash(), cash);
+    EXPECT_EQ(bank.GetAccountsCount(), 4);
+    EXPECT_EQ(bank.GetTotalMoney() + bank.GetCash(), 10000);
+}
+
+// Ошибка записи имитируется ограничением размера файлов процесса: следующая запись в сегмент вернет EFBIG
+TEST(BankJournalTest, RefusesOperationsAfterWriteFailure)
+{
+    JournalDirectory directory("failure");
+    AccountId first;
+    AccountId second;
+    {
+        Bank bank(1000, directory.GetPath());
+        first = bank.OpenAccount();
+        second = bank.OpenAccount();
+        bank.DepositMoney(first, 500);
+
+        rlimit previousLimit{};
+        getrlimit(RLIMIT_FSIZE, &previousLimit);
+        auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+        rlimit limit{static_cast<rlim_t>(std::filesystem::file_size(directory.ListSegments().back())),
+                     previousLimit.rlim_max};
+        setrlimit(RLIMIT_FSIZE, &limit);
+
+        // перевод уже применен в памяти, но подтвердить его на диске не удалось
+        EXPECT_THROW(bank.SendMoney(first, second, 100), std::exception);
+        Money firstBalance = bank.GetAccountBalance(first);
+        Money secondBalance = bank.GetAccountBalance(second);
+
+        EXPECT_THROW(bank.SendMoney(first, second, 50), std::exception);
+        EXPECT_THROW(bank.DepositMoney(second, 10), std::exception);
+        EXPECT_THROW(bank.WithdrawMoney(first, 10), std::exception);
+        EXPECT_THROW(bank.OpenAccount(), std::exception);
+        EXPECT_THROW(bank.CloseAccount(second), std::exception);
+        std::vector<Transfer> batch{{first, second, 1}};
+        EXPECT_THROW(bank.ApplyBatch(batch), std::exception);
+        EXPECT_THROW(bank.Checkpoint(), std::exception);
+
+        EXPECT_EQ(bank.GetAccountBalance(first), firstBalance);
+        EXPECT_EQ(bank.GetAccountBalance(second), secondBalance);
+        EXPECT_EQ(bank.GetAccountsCount(), 2);
+        EXPECT_EQ(bank.GetTotalMoney() + bank.GetCash(), 1000);
+
+        setrlimit(RLIMIT_FSIZE, &previousLimit);
+        std::signal(SIGXFSZ, previousHandler);
+    }
+
+    // на диск попало только то, что было подтверждено до ошибки
+    Bank bank(1000, directory.GetPath());
+    EXPECT_EQ(bank.GetAccountBalance(first), 500);
+    EXPECT_EQ(bank.GetAccountBalance(second), 0);
+    EXPECT_EQ(bank.GetCash(), 500);
+}
+
+TEST(WorkloadTest, RunsTwiceOnTheSameJournal)
+{
+    JournalDirectory directory("workload");
+    WorkloadConfig config;
+    config.accountsCount = 50;
+    config.threadsCount = 2;
+    config.durationSeconds = 0.05;
+    const Money bankBalance = static_cast<Money>(config.accountsCount) * Workload::INITIAL_BALANCE * 2;
+
+    for (int run = 0; run < 2; ++run)
+    {
+        Bank bank(bankBalance, directory.GetPath());
+        Workload workload(bank, config);
+        WorkloadReport report = workload.Run();
+
+        EXPECT_GT(report.completedCount, 0);
+        EXPECT_EQ(report.failedCount, 0);
+        EXPECT_EQ(bank.GetAccountsCount(), 0);
+        EXPECT_EQ(bank.GetCash(), bankBalance);
+    }
+}
+
+// счета прерванного прогона остались в журнале и держат почти все деньги банка
+TEST(WorkloadTest, FundsAccountsFromRemainingCash)
+{
+    JournalDirectory directory("workload-leftover");
+    WorkloadConfig config;
+    config.accountsCount = 50;
+    config.threadsCount = 2;
+    config.durationSeconds = 0.05;
+    const Money bankBalance = static_cast<Money>(config.accountsCount) * Workload::INITIAL_BALANCE * 2;
+    {
+        Bank bank(bankBalance, directory.GetPath());
+        OpenAccounts(bank, 10, bankBalance / 10 - 100);
+    }
+
+    Bank bank(bankBalance, directory.GetPath());
+    Workload workload(bank, config);
+    WorkloadReport report = workload.Run();
+
+    EXPECT_GT(report.completedCount, 0);
+    EXPECT_EQ(report.failedCount, 0);
+    EXPECT_EQ(bank.GetAccountsCount(), 10);
+    EXPECT_EQ(bank.GetTotalMoney() + bank.GetCash(), bankBalance);
+}